@@ -0,0 +1,62 @@
+/*
+// check_async.cpp - Checks -async loaders against the stub libGL - Public Domain
+//
+// Starts resolving with OpenGLInitAsync and keeps the main thread busy like
+// a program loading assets, polling OpenGLIsReady. Checks that every lookup
+// ran on the worker thread, that all functions are resolved once it is ready,
+// and reports how much work the main thread got done in the meantime.
+//
+// Example:
+//    glgen_check_async
+*/
+
+#include "check_async.generated.h"
+#include "stub_gl.h"
+
+// Stands in for decoding an asset, so the main thread has something to do.
+static unsigned int LoadAsset(unsigned int Seed)
+{
+  for (int Index = 0; Index < 1000; ++Index)
+  {
+    Seed = Seed*1664525u + 1013904223u;
+  }
+  return Seed;
+}
+
+int main()
+{
+  int Failed = 0;
+  GLStubLookupLatency = 100000;
+  double Start = GetTime();
+  OpenGLInitAsync();
+  unsigned int Assets = 0;
+  volatile unsigned int Seed = 1;
+  while (!OpenGLIsReady())
+  {
+    Seed = LoadAsset(Seed);
+    Assets++;
+  }
+  double Ready = GetTime();
+  OpenGLVersion Version;
+  OpenGLWaitReady(&Version);
+
+  int Resolved = 0;
+  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)
+  {
+    Resolved += GEN_PROCS[Index] != 0;
+  }
+  Failed |= Check(GLStubThreadLookups == 0, "no lookup ran on the main thread");
+  Failed |= Check(GLStubLookups == GEN_PROC_COUNT, "every function was looked up once");
+  Failed |= Check(Resolved == GEN_PROC_COUNT, "every function is resolved once ready");
+  Failed |= Check(Version.Major == 4 && Version.Minor == 6, "OpenGLWaitReady reports 4.6");
+
+  glViewport(0, 0, 640, 480);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  Failed |= Check(GLStubCalls("glDrawArrays") == 1, "calls reach the driver");
+
+  printf("     %d lookups of %lld us took %.2f ms on the worker, the main thread loaded %u assets\n",
+         GEN_PROC_COUNT, GLStubLookupLatency/1000, (Ready - Start)*1000.0, Assets);
+  OpenGLShutdown();
+  return Failed;
+}
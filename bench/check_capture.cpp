@@ -0,0 +1,71 @@
+/*
+// check_capture.cpp - Checks -capture traces against the stub libGL - Public Domain
+//
+// Captures calls that read client memory and calls that take buffer offsets,
+// overwrites the client memory, and replays the trace. The stub hashes what
+// the calls read. Checks that the replay reads the same uniforms, shader
+// strings and rows of pixels at the unpack alignment as the live calls, and
+// gets the same pixel and vertex attribute offsets.
+//
+// Example:
+//    glgen_check_capture
+*/
+
+#include "check_capture.generated.h"
+#include "stub_gl.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE "check_capture.trace"
+
+int main()
+{
+  int Failed = 0;
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+
+  char Source[] = "#version 460\nvoid main() {}\n// not compiled";
+  const GLchar* Strings[2] = {"#version 460\n", Source};
+  GLint Lengths[2] = {-1, 27};
+  GLfloat Uniforms[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  //NOTE: Rows of 3 GL_RGB texels are 9 bytes, padded to 12 at the default
+  // unpack alignment of 4 and read unpadded at 1.
+  unsigned char Pixels[24];
+  for (int Index = 0; Index < 24; ++Index)
+  {
+    Pixels[Index] = (unsigned char)(Index*7 + 1);
+  }
+
+  GLStubDataHash = 0;
+  Failed |= Check(OpenGLCaptureStart(TRACE), "the trace file is created");
+  glShaderSource(1, 2, Strings, Lengths);
+  glUniform4fv(0, 2, Uniforms);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 3, 2, GL_RGB, GL_UNSIGNED_BYTE, Pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 3, 2, GL_RGB, GL_UNSIGNED_BYTE, Pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 9);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 3, 2, GL_RGB, GL_UNSIGNED_BYTE, (const void*)64);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 16, (const void*)32);
+  OpenGLCaptureStop();
+  unsigned long long Hash = GLStubDataHash;
+
+  memset(Source, 0, sizeof(Source));
+  memset(Uniforms, 0, sizeof(Uniforms));
+  memset(Pixels, 0, sizeof(Pixels));
+  GLStubDataHash = 0;
+  GLStubPixelOffset = 0;
+  GLStubAttribPointer = 0;
+  long long Calls = OpenGLReplayTrace(TRACE);
+  Failed |= Check(Calls == 10, "every captured call is replayed");
+  Failed |= Check(GLStubDataHash == Hash,
+                  "the replay reads the strings, uniforms and pixels the capture saw");
+  Failed |= Check(GLStubPixelOffset == (const void*)64 && GLStubAttribPointer == (const void*)32,
+                  "the replay gets the pixel and vertex attribute offsets");
+  unlink(TRACE);
+
+  OpenGLShutdown();
+  return Failed;
+}
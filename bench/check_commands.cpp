@@ -0,0 +1,73 @@
+/*
+// check_commands.cpp - Checks -commands buffers against the stub libGL - Public Domain
+//
+// A worker records uniforms, shader strings and a vertex attribute offset
+// from its own stack into a command buffer and returns, then the main thread
+// executes the buffer. The stub hashes what the calls read. Checks that
+// nothing reaches the driver while recording, and that executing reads the
+// same data and gets the same offset as making the calls directly.
+//
+// Example:
+//    glgen_check_commands
+*/
+
+#include "check_commands.generated.h"
+#include "stub_gl.h"
+
+#include <pthread.h>
+#include <string.h>
+
+static OpenGLCommandBuffer Commands;
+
+// Makes the calls with data on the stack, which is overwritten before
+// returning.
+static void MakeCalls()
+{
+  char Source[] = "#version 460\nvoid main() {}\n";
+  const GLchar* Strings[2] = {"#version 460\n", Source};
+  GLint Lengths[2] = {-1, 13};
+  GLfloat Uniforms[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  glShaderSource(1, 2, Strings, Lengths);
+  glUniform4fv(0, 2, Uniforms);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 16, (const void*)32);
+  memset(Source, 0, sizeof(Source));
+  memset(Uniforms, 0, sizeof(Uniforms));
+}
+
+static void* RecordThread(void*)
+{
+  OpenGLBeginCommands(&Commands);
+  MakeCalls();
+  OpenGLEndCommands();
+  return 0;
+}
+
+int main()
+{
+  int Failed = 0;
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+
+  GLStubDataHash = 0;
+  MakeCalls();
+  unsigned long long Hash = GLStubDataHash;
+
+  GLStubDataHash = 0;
+  GLStubAttribPointer = 0;
+  pthread_t Thread;
+  pthread_create(&Thread, 0, RecordThread, 0);
+  pthread_join(Thread, 0);
+  Failed |= Check(GLStubCalls("glUniform4fv") == 1 && GLStubCalls("glShaderSource") == 1 &&
+                  GLStubCalls("glVertexAttribPointer") == 1,
+                  "recorded calls don't reach the driver");
+
+  size_t Calls = OpenGLExecuteCommands(&Commands);
+  Failed |= Check(Calls == 3, "every recorded call is made");
+  Failed |= Check(GLStubDataHash == Hash,
+                  "executing reads the strings and uniforms the worker passed");
+  Failed |= Check(GLStubAttribPointer == (const void*)32, "executing gets the vertex attribute offset");
+
+  OpenGLFreeCommands(&Commands);
+  OpenGLShutdown();
+  return Failed;
+}
@@ -0,0 +1,93 @@
+/*
+// check_init.cpp - Stresses OpenGLInit from many threads against the stub libGL - Public Domain
+//
+// Every round, all threads call OpenGLInit at the same time, the main thread
+// checks that the functions were looked up exactly once, and all threads call
+// OpenGLShutdown at the same time. Every thread has to come back from
+// OpenGLInit with the table published and the version of the stub, and the
+// table is only dropped by the last OpenGLShutdown.
+//
+// Example:
+//    glgen_check_init
+*/
+
+#include "check_init.generated.h"
+#include "stub_gl.h"
+
+#include <pthread.h>
+
+#define THREADS 8
+#define ROUNDS 200
+
+static pthread_barrier_t Barrier;
+static long Failures;
+
+static void* InitThread(void* Param)
+{
+  (void)Param;
+  for (int Round = 0; Round < ROUNDS; ++Round)
+  {
+    pthread_barrier_wait(&Barrier);
+    OpenGLVersion Version;
+    OpenGLInit(&Version);
+    if (!OpenGLIsInitialized() || Version.Major != 4 || Version.Minor != 6 || !GEN_PROCS[GEN_ID_glDrawArrays])
+    {
+      __atomic_fetch_add(&Failures, 1, __ATOMIC_RELAXED);
+    }
+    pthread_barrier_wait(&Barrier);
+    OpenGLShutdown();
+    pthread_barrier_wait(&Barrier);
+  }
+  return 0;
+}
+
+int main()
+{
+  int Failed = 0;
+  //NOTE: Slow lookups keep the resolving thread inside OpenGLInit long
+  // enough for the others to pile up on the lock.
+  GLStubLookupLatency = 2000;
+  pthread_barrier_init(&Barrier, 0, THREADS + 1);
+  pthread_t Threads[THREADS];
+  for (int Thread = 0; Thread < THREADS; ++Thread)
+  {
+    pthread_create(Threads + Thread, 0, InitThread, 0);
+  }
+  int ExtraLookups = 0;
+  int Kept = 0;
+  for (int Round = 0; Round < ROUNDS; ++Round)
+  {
+    long Lookups = GLStubLookups;
+    pthread_barrier_wait(&Barrier);
+    pthread_barrier_wait(&Barrier);
+    ExtraLookups += GLStubLookups - Lookups != GEN_PROC_COUNT;
+    pthread_barrier_wait(&Barrier);
+    Kept += OpenGLIsInitialized() != 0;
+  }
+  for (int Thread = 0; Thread < THREADS; ++Thread)
+  {
+    pthread_join(Threads[Thread], 0);
+  }
+  printf("     %d threads x %d rounds of OpenGLInit\n", THREADS, ROUNDS);
+  Failed |= Check(Failures == 0, "every thread sees a published table and version 4.6");
+  Failed |= Check(Kept == 0, "the last of the concurrent shutdowns drops the table");
+  Failed |= Check(ExtraLookups == 0, "each round looks every function up exactly once");
+
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+  long Lookups = GLStubLookups;
+  OpenGLInit(&Version);
+  Failed |= Check(GLStubLookups == Lookups, "initializing again on the same driver looks nothing up");
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  Failed |= Check(GLStubCalls("glDrawArrays") == 1, "calls reach the driver");
+
+  OpenGLShutdown();
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  Failed |= Check(OpenGLIsInitialized() && GLStubCalls("glDrawArrays") == 2,
+                  "the table is kept while another OpenGLInit holds a reference");
+  OpenGLShutdown();
+  Failed |= Check(!OpenGLIsInitialized() && !GEN_PROCS[GEN_ID_glDrawArrays],
+                  "the last OpenGLShutdown drops the table");
+  pthread_barrier_destroy(&Barrier);
+  return Failed;
+}
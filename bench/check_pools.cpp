@@ -0,0 +1,91 @@
+/*
+// check_pools.cpp - Measures -pools name generation against the stub libGL - Public Domain
+//
+// Generates buffer names one at a time, first straight from the driver and
+// then through the pooled glGenBuffers wrapper, with a delay on every driver
+// call that creates or deletes names. Reports the driver calls and the time
+// per name of both and checks that the pools refill once per
+// GEN_NAME_POOL_SIZE names, never hand a name out twice, are kept per context
+// and are dropped by OpenGLInit.
+//
+// Example:
+//    glgen_check_pools
+*/
+
+#include "check_pools.generated.h"
+#include "stub_gl.h"
+
+#define NAMES (100*GEN_NAME_POOL_SIZE)
+#define MAX_NAME (1 << 16)
+
+static unsigned char Seen[MAX_NAME];
+
+// Marks Name as handed out. Returns zero if it was before.
+static int IsNewName(GLuint Name)
+{
+  int Result = Name < MAX_NAME && !Seen[Name];
+  if (Name < MAX_NAME)
+  {
+    Seen[Name] = 1;
+  }
+  return Result;
+}
+
+int main()
+{
+  int Failed = 0;
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+  GLStubCallLatency = 1000;
+
+  GLuint Name = 0;
+  double Start = GetTime();
+  for (int Index = 0; Index < NAMES; ++Index)
+  {
+    GEN_glGenBuffers(1, &Name);
+  }
+  double Direct = GetTime() - Start;
+  long DirectCalls = GLStubCalls("glGenBuffers");
+
+  int Unique = 1;
+  Start = GetTime();
+  for (int Index = 0; Index < NAMES; ++Index)
+  {
+    glGenBuffers(1, &Name);
+    Unique &= IsNewName(Name);
+  }
+  double Pooled = GetTime() - Start;
+  long PooledCalls = GLStubCalls("glGenBuffers") - DirectCalls;
+
+  printf("     %d names with %lld ns per driver call\n", NAMES, GLStubCallLatency);
+  printf("     direct: %6ld driver calls, %7.1f ns per name\n", DirectCalls, Direct*1e9/NAMES);
+  printf("     pooled: %6ld driver calls, %7.1f ns per name\n", PooledCalls, Pooled*1e9/NAMES);
+  Failed |= Check(PooledCalls == NAMES/GEN_NAME_POOL_SIZE, "the pool refills once per GEN_NAME_POOL_SIZE names");
+  Failed |= Check(Unique, "no name is handed out twice");
+
+  //NOTE: The default pool is empty after NAMES names, taking one refills it.
+  glGenBuffers(1, &Name);
+  static OpenGLNamePools Other;
+  OpenGLMakeNamePoolsCurrent(&Other);
+  long Calls = GLStubCalls("glGenBuffers");
+  glGenBuffers(1, &Name);
+  Unique = IsNewName(Name);
+  glGenBuffers(1, &Name);
+  Unique &= IsNewName(Name);
+  Failed |= Check(GLStubCalls("glGenBuffers") == Calls + 1 && Unique,
+                  "another context fills its own pool");
+  OpenGLMakeNamePoolsCurrent(0);
+
+  Calls = GLStubCalls("glGenBuffers");
+  OpenGLInit(&Version);
+  glGenBuffers(1, &Name);
+  Failed |= Check(GLStubCalls("glGenBuffers") == Calls + 1, "OpenGLInit drops the names of the previous context");
+
+  long Deletes = GLStubCalls("glDeleteBuffers");
+  OpenGLFreeNamePools();
+  glDeleteBuffers(1, &Name);
+  Failed |= Check(GLStubCalls("glDeleteBuffers") == Deletes + 2, "OpenGLFreeNamePools deletes the names left");
+
+  OpenGLShutdown();
+  return Failed;
+}
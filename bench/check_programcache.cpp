@@ -0,0 +1,120 @@
+/*
+// check_programcache.cpp - Checks -programcache against the stub libGL - Public Domain
+//
+// Builds a program the way a renderer would: load it from the cache, and
+// compile, link and save it when that fails. The stub hands out a fake binary
+// that only links on the renderer it came from. Checks that a cold start
+// compiles and saves, a warm start loads without compiling, changed sources
+// or another driver get their own key, and binaries the driver rejects are
+// removed from the cache.
+//
+// Example:
+//    glgen_check_programcache
+*/
+
+#include "check_programcache.generated.h"
+#include "stub_gl.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char* Sources[2] =
+{
+  "#version 460\nvoid main() { gl_Position = vec4(0.0); }\n",
+  "#version 460\nout vec4 Color;\nvoid main() { Color = vec4(1.0); }\n",
+};
+
+static const GLenum ShaderTypes[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+
+// Loads the program cached under Key, or compiles, links and caches it.
+static GLuint BuildProgram(const char* Directory, unsigned long long Key, int* Loaded)
+{
+  GLuint Program = glCreateProgram();
+  *Loaded = OpenGLLoadProgram(Program, Directory, Key);
+  if (!*Loaded)
+  {
+    GLuint Shaders[2];
+    for (int Index = 0; Index < 2; ++Index)
+    {
+      Shaders[Index] = glCreateShader(ShaderTypes[Index]);
+      glShaderSource(Shaders[Index], 1, Sources + Index, 0);
+      glCompileShader(Shaders[Index]);
+      glAttachShader(Program, Shaders[Index]);
+    }
+    glProgramParameteri(Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(Program);
+    for (int Index = 0; Index < 2; ++Index)
+    {
+      glDeleteShader(Shaders[Index]);
+    }
+    OpenGLSaveProgram(Program, Directory, Key);
+  }
+  return Program;
+}
+
+static int IsCached(const char* Directory, unsigned long long Key)
+{
+  char Path[1024];
+  snprintf(Path, sizeof(Path), "%s/%016llx.glbin", Directory, Key);
+  return access(Path, F_OK) == 0;
+}
+
+int main()
+{
+  int Failed = 0;
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+  char Directory[] = "/tmp/glgen_check_programcache_XXXXXX";
+  if (!mkdtemp(Directory))
+  {
+    printf("Couldn't create a directory for the cache\n");
+    return 1;
+  }
+
+  unsigned long long Key = OpenGLProgramKey(Sources, 2);
+  Failed |= Check(Key == OpenGLProgramKey(Sources, 2), "the key of the same sources and driver is stable");
+  int Loaded = 0;
+  GLuint Program = BuildProgram(Directory, Key, &Loaded);
+  Failed |= Check(!Loaded && GLStubCalls("glCompileShader") == 2, "a cold start compiles");
+  Failed |= Check(IsCached(Directory, Key), "a cold start saves the binary");
+
+  long Compiles = GLStubCalls("glCompileShader");
+  GLuint Warm = BuildProgram(Directory, Key, &Loaded);
+  GLint Linked = 0;
+  glGetProgramiv(Warm, GL_LINK_STATUS, &Linked);
+  Failed |= Check(Loaded && Linked && GLStubCalls("glCompileShader") == Compiles,
+                  "a warm start loads the binary without compiling");
+
+  //NOTE: The binary of the warm program must be what the cold one linked.
+  char Binaries[2][256];
+  GLsizei Lengths[2] = {0, 0};
+  GLenum Formats[2] = {0, 0};
+  glGetProgramBinary(Program, sizeof(Binaries[0]), Lengths, Formats, Binaries[0]);
+  glGetProgramBinary(Warm, sizeof(Binaries[1]), Lengths + 1, Formats + 1, Binaries[1]);
+  Failed |= Check(Lengths[0] > 0 && Lengths[0] == Lengths[1] && Formats[0] == Formats[1] &&
+                  memcmp(Binaries[0], Binaries[1], (size_t)Lengths[0]) == 0,
+                  "the loaded binary is the one that was saved");
+
+  const char* Changed[2] = {Sources[0], "#version 460\nout vec4 Color;\nvoid main() { Color = vec4(0.5); }\n"};
+  Failed |= Check(OpenGLProgramKey(Changed, 2) != Key, "changed sources get another key");
+
+  GLStubRenderer = "stub after a driver update";
+  unsigned long long UpdatedKey = OpenGLProgramKey(Sources, 2);
+  Failed |= Check(UpdatedKey != Key, "another driver gets another key");
+  BuildProgram(Directory, UpdatedKey, &Loaded);
+  Failed |= Check(!Loaded && GLStubCalls("glCompileShader") == Compiles + 2, "another driver compiles again");
+
+  //NOTE: A binary saved by the old driver under a key that still matches, as
+  // if the driver changed without changing its strings.
+  GLuint Stale = glCreateProgram();
+  Failed |= Check(!OpenGLLoadProgram(Stale, Directory, Key) && !IsCached(Directory, Key),
+                  "a binary the driver rejects is removed");
+
+  char Path[1024];
+  snprintf(Path, sizeof(Path), "%s/%016llx.glbin", Directory, UpdatedKey);
+  remove(Path);
+  rmdir(Directory);
+  OpenGLShutdown();
+  return Failed;
+}
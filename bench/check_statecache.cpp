@@ -0,0 +1,100 @@
+/*
+// check_statecache.cpp - Checks -statecache wrappers against the stub libGL - Public Domain
+//
+// Makes the same binding and state calls over and over, like a renderer that
+// sets everything per draw, and counts how many reach the driver. Checks that
+// redundant calls are skipped, that changes, deletes, invalidation and a new
+// context state let calls through, and that queries of known state are
+// answered without the driver under any of their names.
+//
+// Example:
+//    glgen_check_statecache
+*/
+
+#include "check_statecache.generated.h"
+#include "stub_gl.h"
+
+#define DRAWS 1000
+
+static void SetState(GLuint Buffer)
+{
+  glUseProgram(7);
+  glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 3);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthFunc(GL_LEQUAL);
+  glViewport(0, 0, 640, 480);
+}
+
+static long GetStateCalls()
+{
+  return GLStubCalls("glUseProgram") + GLStubCalls("glBindBuffer") + GLStubCalls("glActiveTexture") +
+         GLStubCalls("glBindTexture") + GLStubCalls("glEnable") + GLStubCalls("glBlendFunc") +
+         GLStubCalls("glDepthFunc") + GLStubCalls("glViewport");
+}
+
+int main()
+{
+  int Failed = 0;
+  OpenGLVersion Version;
+  OpenGLInit(&Version);
+  GLuint Buffers[2];
+  glGenBuffers(2, Buffers);
+
+  for (int Draw = 0; Draw < DRAWS; ++Draw)
+  {
+    SetState(Buffers[0]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+  long Calls = GetStateCalls();
+  Failed |= Check(Calls == 8, "each state is set once over all draws");
+  Failed |= Check(GLStubCalls("glDrawArrays") == DRAWS, "draws always reach the driver");
+  printf("     %d state calls made, %ld reached the driver\n", 8*DRAWS, Calls);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Buffers[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, Buffers[1]);
+  glDisable(GL_BLEND);
+  glEnable(GL_BLEND);
+  Failed |= Check(GetStateCalls() == Calls + 3 && GLStubCalls("glDisable") == 1,
+                  "changed state reaches the driver");
+
+  long Queries = GLStubCalls("glGetIntegerv");
+  GLint Bound = 0;
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &Bound);
+  Failed |= Check(Bound == (GLint)Buffers[1] && GLStubCalls("glGetIntegerv") == Queries,
+                  "the shadow answers GL_ARRAY_BUFFER_BINDING");
+
+  //NOTE: GL_BLEND_EQUATION and GL_FRAMEBUFFER_BINDING are the other names of
+  // GL_BLEND_EQUATION_RGB and GL_DRAW_FRAMEBUFFER_BINDING.
+  glBlendEquation(GL_FUNC_SUBTRACT);
+  glBindFramebuffer(GL_FRAMEBUFFER, 5);
+  GLint Equation = 0;
+  GLint Framebuffer = 0;
+  glGetIntegerv(GL_BLEND_EQUATION, &Equation);
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &Framebuffer);
+  Failed |= Check(Equation == GL_FUNC_SUBTRACT && Framebuffer == 5 && GLStubCalls("glGetIntegerv") == Queries,
+                  "the shadow answers GL_BLEND_EQUATION and GL_FRAMEBUFFER_BINDING");
+
+  //NOTE: Deleting a bound buffer unbinds it, so binding zero changes nothing.
+  Calls = GetStateCalls();
+  glDeleteBuffers(1, Buffers + 1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  Failed |= Check(GetStateCalls() == Calls, "deleting a bound buffer unbinds it in the shadow");
+
+  OpenGLInvalidateStateCache();
+  SetState(Buffers[0]);
+  Failed |= Check(GetStateCalls() == Calls + 8, "every state is set again after invalidating");
+
+  static OpenGLContextState Other;
+  OpenGLMakeContextStateCurrent(&Other);
+  SetState(Buffers[0]);
+  Failed |= Check(GetStateCalls() == Calls + 16, "another context state starts out unknown");
+  OpenGLMakeContextStateCurrent(0);
+  SetState(Buffers[0]);
+  Failed |= Check(GetStateCalls() == Calls + 16, "the default state is kept while another is current");
+
+  OpenGLShutdown();
+  return Failed;
+}
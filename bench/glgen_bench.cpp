@@ -0,0 +1,572 @@
+/*
+// glgen_bench.cpp - Benchmarks for glgen's scanner and tables - Public Domain
+//
+// Builds a deterministic synthetic corpus of source files and a registry,
+// then measures ParseToken, GetStringHash, ArbHash lookups, the registry
+// parse and end-to-end generation. No GPU or OpenGL installation is needed.
+//
+// Example:
+//    glgen_bench -files 64 -size 256 -symbols 30 -comments 20 -strings 10
+//    glgen_bench -gl glcorearb.h,glext.h
+*/
+
+#define GLGEN_NO_MAIN
+#include "../glgen.cpp"
+
+#if _MSC_VER
+  #include <direct.h> // _mkdir
+  #define MakeDirectory(Path) _mkdir(Path)
+#else
+  #define MakeDirectory(Path) mkdir(Path, 0755)
+#endif
+
+struct BenchSettings
+{
+  const char* Directory;
+  char* Registry;
+  int FileCount;
+  int FileSize;
+  int SymbolDensity;
+  int CommentDensity;
+  int StringDensity;
+  int FunctionCount;
+  int DefineCount;
+  int Iterations;
+  unsigned long long Seed;
+};
+
+struct BenchResult
+{
+  double Best;
+  double Median;
+};
+
+static const char* Words[16] =
+{
+  "Get", "Set", "Bind", "Gen", "Delete", "Create", "Named", "Buffer",
+  "Texture", "Program", "Uniform", "Vertex", "Attrib", "Sub", "Data", "Parameter",
+};
+
+static const char* Suffixes[8] =
+{
+  "", "i", "f", "iv", "fv", "ARB", "EXT", "NV",
+};
+
+static const char* Text[16] =
+{
+  "the", "frame", "draws", "every", "visible", "mesh", "with", "a",
+  "single", "call", "unless", "state", "changed", "since", "last", "time",
+};
+
+// xorshift64*, so the corpus is the same for a seed on every platform.
+static inline
+unsigned int NextRandom(unsigned long long* State)
+{
+  *State ^= *State >> 12;
+  *State ^= *State << 25;
+  *State ^= *State >> 27;
+  return (unsigned int)((*State*2685821657736338717ull) >> 32);
+}
+
+static
+void GetSyntheticName(char* Name, const char* Prefix, int Index, int Upper)
+{
+  Name += sprintf(Name, "%s", Prefix);
+  for (int Word = 0; Word < 3; ++Word)
+  {
+    const char* At = Words[(Index >> (4*Word)) & 15];
+    if (Upper && Word)
+    {
+      *Name++ = '_';
+    }
+    while (*At)
+    {
+      *Name++ = Upper ? (char)toupper(*At) : *At;
+      At++;
+    }
+  }
+  sprintf(Name, "%s", Upper ? "" : Suffixes[(Index >> 12) & 7]);
+  if (Upper && Index >> 12)
+  {
+    sprintf(Name, "_%d", Index >> 12);
+  }
+}
+
+// Writes a registry in the layout of glcorearb.h with FunctionCount functions
+// and DefineCount defines spread over feature blocks of 64 functions.
+static
+char* WriteSyntheticRegistry(BenchSettings* Settings)
+{
+  char* Path = (char*)malloc(strlen(Settings->Directory) + 32);
+  sprintf(Path, "%s/synthetic_glcorearb.h", Settings->Directory);
+  FILE* File = fopen(Path, "w");
+  if (File)
+  {
+    fprintf(File,
+            "#ifndef __gl_glcorearb_h_\n"
+            "#define __gl_glcorearb_h_ 1\n"
+            "#ifndef APIENTRY\n#define APIENTRY\n#endif\n"
+            "#ifndef APIENTRYP\n#define APIENTRYP APIENTRY *\n#endif\n"
+            "#ifndef GLAPI\n#define GLAPI extern\n#endif\n"
+            "typedef unsigned int GLenum;\n"
+            "typedef unsigned int GLuint;\n"
+            "typedef int GLint;\n"
+            "typedef int GLsizei;\n"
+            "typedef float GLfloat;\n"
+            "typedef unsigned char GLubyte;\n");
+    int Blocks = (Settings->FunctionCount + 63)/64;
+    int DefinesPerBlock = (Settings->DefineCount + Blocks - 1)/Blocks;
+    int Define = 0;
+    char Name[128];
+    for (int Function = 0, Block = 0; Function < Settings->FunctionCount; ++Block)
+    {
+      fprintf(File, "#ifndef GL_VERSION_%d_%d\n#define GL_VERSION_%d_%d 1\n",
+              1 + Block/10, Block%10, 1 + Block/10, Block%10);
+      for (int Index = 0; Index < DefinesPerBlock && Define < Settings->DefineCount; ++Index, ++Define)
+      {
+        GetSyntheticName(Name, "GL_", Define, 1);
+        fprintf(File, "#define %s 0x%04X\n", Name, 0x1000 + Define);
+      }
+      int End = Function + 64 < Settings->FunctionCount ? Function + 64 : Settings->FunctionCount;
+      for (int Index = Function; Index < End; ++Index)
+      {
+        GetSyntheticName(Name, "gl", Index, 0);
+        char Upper[128];
+        GLString String = {Name, (unsigned int)strlen(Name)};
+        UpperCase(Upper, String);
+        const char* Parameters = (Index & 3) == 0 ? "(GLenum target, GLuint index)" :
+                                 (Index & 3) == 1 ? "(GLsizei n, GLuint *names)" :
+                                 (Index & 3) == 2 ? "(GLint location, GLfloat v0)" : "(void)";
+        fprintf(File, "typedef void (APIENTRYP PFN%sPROC) %s;\n", Upper, Parameters);
+      }
+      fprintf(File, "#ifdef GL_GLEXT_PROTOTYPES\n");
+      for (int Index = Function; Index < End; ++Index)
+      {
+        GetSyntheticName(Name, "gl", Index, 0);
+        const char* Parameters = (Index & 3) == 0 ? "(GLenum target, GLuint index)" :
+                                 (Index & 3) == 1 ? "(GLsizei n, GLuint *names)" :
+                                 (Index & 3) == 2 ? "(GLint location, GLfloat v0)" : "(void)";
+        fprintf(File, "GLAPI void APIENTRY %s %s;\n", Name, Parameters);
+      }
+      fprintf(File, "#endif\n#endif /* GL_VERSION_%d_%d */\n", 1 + Block/10, Block%10);
+      Function = End;
+    }
+    fprintf(File, "#endif\n");
+    fclose(File);
+  }
+  else
+  {
+    fprintf(stderr, "Couldn't open file %s\n", Path);
+    free(Path);
+    Path = 0;
+  }
+  return Path;
+}
+
+// Writes one line of the corpus: a GL call, a comment, a string literal or
+// plain code, picked with the configured densities.
+static
+int WriteCorpusLine(char* Line, BenchSettings* Settings, unsigned long long* Random,
+                    GLArbToken** Functions, unsigned int FunctionCount,
+                    GLArbToken** Defines, unsigned int DefineCount)
+{
+  char* At = Line;
+  unsigned int Pick = NextRandom(Random) % 100;
+  unsigned int WordCount = 4 + NextRandom(Random) % 8;
+  if (Pick < (unsigned int)Settings->SymbolDensity && FunctionCount && DefineCount)
+  {
+    GLString Function = Functions[NextRandom(Random) % FunctionCount]->Value;
+    GLString Define = Defines[NextRandom(Random) % DefineCount]->Value;
+    At += sprintf(At, "  %" PRI_STR "(%" PRI_STR ", Object%u);\n", Function.Length, Function.Chars,
+                  Define.Length, Define.Chars, NextRandom(Random) % 1000);
+  }
+  else if (Pick < (unsigned int)(Settings->SymbolDensity + Settings->CommentDensity))
+  {
+    At += sprintf(At, "  //");
+    for (unsigned int Word = 0; Word < WordCount; ++Word)
+    {
+      At += sprintf(At, " %s", Text[NextRandom(Random) & 15]);
+    }
+    At += sprintf(At, "\n");
+  }
+  else if (Pick < (unsigned int)(Settings->SymbolDensity + Settings->CommentDensity + Settings->StringDensity))
+  {
+    At += sprintf(At, "  Log(\"");
+    for (unsigned int Word = 0; Word < WordCount; ++Word)
+    {
+      At += sprintf(At, "%s%s", Word ? " " : "", Text[NextRandom(Random) & 15]);
+    }
+    At += sprintf(At, "\");\n");
+  }
+  else
+  {
+    At += sprintf(At, "  int Value%u = Counter%u*%u + Offset;\n", NextRandom(Random) % 1000,
+                  NextRandom(Random) % 100, NextRandom(Random) % 16);
+  }
+  return (int)(At - Line);
+}
+
+// Writes the corpus files and returns their concatenated contents.
+static
+char* WriteCorpus(BenchSettings* Settings, GLArbToken* ArbHash, size_t* Size)
+{
+  GLArbToken** Functions = (GLArbToken**)malloc(sizeof(GLArbToken*)*TOKEN_HASH_SIZE);
+  GLArbToken** Defines = (GLArbToken**)malloc(sizeof(GLArbToken*)*TOKEN_HASH_SIZE);
+  unsigned int FunctionCount = 0;
+  unsigned int DefineCount = 0;
+  for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+  {
+    GLArbToken* Token = ArbHash + Index;
+    if (Token->Hash && Token->FunctionName.Length)
+    {
+      Functions[FunctionCount++] = Token;
+    }
+    else if (Token->Hash && StartsWith(Token->Value, "GL_"))
+    {
+      Defines[DefineCount++] = Token;
+    }
+  }
+
+  size_t FileSize = (size_t)Settings->FileSize*1024;
+  char* Corpus = (char*)malloc(FileSize*(size_t)Settings->FileCount + 1);
+  char* At = Corpus;
+  unsigned long long Random = Settings->Seed ? Settings->Seed : 1;
+  for (int Index = 0; Index < Settings->FileCount; ++Index)
+  {
+    char* Start = At;
+    char Line[512];
+    for (;;)
+    {
+      int Length = WriteCorpusLine(Line, Settings, &Random, Functions, FunctionCount,
+                                   Defines, DefineCount);
+      if ((size_t)(At - Start + Length) > FileSize)
+      {
+        break;
+      }
+      memcpy(At, Line, (size_t)Length);
+      At += Length;
+    }
+    char Path[1024];
+    snprintf(Path, sizeof(Path), "%s/corpus_%04d.cpp", Settings->Directory, Index);
+    FILE* File = fopen(Path, "wb");
+    if (File)
+    {
+      fwrite(Start, (size_t)(At - Start), 1, File);
+      fclose(File);
+    }
+  }
+  *At = 0;
+  *Size = (size_t)(At - Corpus);
+  free(Functions);
+  free(Defines);
+  return Corpus;
+}
+
+static
+int CompareDoubles(const void* A, const void* B)
+{
+  double First = *(const double*)A;
+  double Second = *(const double*)B;
+  return (First > Second) - (First < Second);
+}
+
+static
+BenchResult GetResult(double* Times, int Count)
+{
+  qsort(Times, (size_t)Count, sizeof(double), CompareDoubles);
+  BenchResult Result;
+  Result.Best = Times[0];
+  Result.Median = Times[Count/2];
+  return Result;
+}
+
+static
+void PrintResult(const char* Name, BenchResult Result, double Bytes, double Items, const char* Unit)
+{
+  char Throughput[32] = "-";
+  if (Bytes > 0)
+  {
+    snprintf(Throughput, sizeof(Throughput), "%.1f", Bytes/Result.Median/(1024.0*1024.0));
+  }
+  printf("  %-18s %10.3f %10.3f %10s %10.2f M%s/s\n", Name, Result.Median*1000.0, Result.Best*1000.0,
+         Throughput, Items/Result.Median/1e6, Unit);
+}
+
+static
+void PrintBenchHelp(char** argv)
+{
+  printf("Usage: %s [options]\n", argv[0]);
+  printf("\noptional arguments:\n");
+  printf("  %-20s Directory for the corpus and generated files (default glgen_bench_corpus)\n", "-dir <directory>");
+  printf("  %-20s Use these registry headers instead of a synthetic registry\n", "-gl <file1>,<file2>");
+  printf("  %-20s Number of corpus files (default 64)\n", "-files <count>");
+  printf("  %-20s Size of each corpus file in KB (default 256)\n", "-size <kb>");
+  printf("  %-20s Percentage of lines calling GL functions (default 30)\n", "-symbols <percent>");
+  printf("  %-20s Percentage of comment lines (default 20)\n", "-comments <percent>");
+  printf("  %-20s Percentage of lines with string literals (default 10)\n", "-strings <percent>");
+  printf("  %-20s Functions in the synthetic registry (default 2000)\n", "-functions <count>");
+  printf("  %-20s Defines in the synthetic registry (default 4000)\n", "-defines <count>");
+  printf("  %-20s Runs of each benchmark (default 5)\n", "-iterations <count>");
+  printf("  %-20s Seed of the corpus generator (default 1)\n", "-seed <seed>");
+}
+
+int main(int argc, char** argv)
+{
+  BenchSettings Settings = {};
+  Settings.Directory = "glgen_bench_corpus";
+  Settings.FileCount = 64;
+  Settings.FileSize = 256;
+  Settings.SymbolDensity = 30;
+  Settings.CommentDensity = 20;
+  Settings.StringDensity = 10;
+  Settings.FunctionCount = 2000;
+  Settings.DefineCount = 4000;
+  Settings.Iterations = 5;
+  Settings.Seed = 1;
+  for (int Index = 1; Index < argc; ++Index)
+  {
+    const char* Option = argv[Index];
+    const char* Value = Index + 1 < argc ? argv[Index + 1] : 0;
+    if (!Value || Option[0] != '-')
+    {
+      PrintBenchHelp(argv);
+      return 1;
+    }
+    if (strcmp(Option, "-dir") == 0)
+    {
+      Settings.Directory = Value;
+    }
+    else if (strcmp(Option, "-gl") == 0)
+    {
+      Settings.Registry = (char*)Value;
+    }
+    else if (strcmp(Option, "-files") == 0)
+    {
+      Settings.FileCount = atoi(Value);
+    }
+    else if (strcmp(Option, "-size") == 0)
+    {
+      Settings.FileSize = atoi(Value);
+    }
+    else if (strcmp(Option, "-symbols") == 0)
+    {
+      Settings.SymbolDensity = atoi(Value);
+    }
+    else if (strcmp(Option, "-comments") == 0)
+    {
+      Settings.CommentDensity = atoi(Value);
+    }
+    else if (strcmp(Option, "-strings") == 0)
+    {
+      Settings.StringDensity = atoi(Value);
+    }
+    else if (strcmp(Option, "-functions") == 0)
+    {
+      Settings.FunctionCount = atoi(Value);
+    }
+    else if (strcmp(Option, "-defines") == 0)
+    {
+      Settings.DefineCount = atoi(Value);
+    }
+    else if (strcmp(Option, "-iterations") == 0)
+    {
+      Settings.Iterations = atoi(Value);
+    }
+    else if (strcmp(Option, "-seed") == 0)
+    {
+      Settings.Seed = strtoull(Value, 0, 10);
+    }
+    else
+    {
+      PrintBenchHelp(argv);
+      return 1;
+    }
+    Index++;
+  }
+  //NOTE: ArbHash doesn't grow, the registry has to leave some slots free.
+  if (Settings.FileCount < 1 || Settings.FileSize < 1 || Settings.Iterations < 1 || Settings.FunctionCount < 1 ||
+      Settings.FunctionCount + Settings.DefineCount > TOKEN_HASH_SIZE*7/8)
+  {
+    fprintf(stderr, "Invalid settings, at most %d functions and defines\n", TOKEN_HASH_SIZE*7/8);
+    return 1;
+  }
+  MakeDirectory(Settings.Directory);
+
+  char* Registry = Settings.Registry;
+  if (Registry)
+  {
+    Registry = (char*)malloc(strlen(Settings.Registry) + 1);
+    strcpy(Registry, Settings.Registry);
+  }
+  else
+  {
+    Registry = WriteSyntheticRegistry(&Settings);
+  }
+  if (!Registry)
+  {
+    return 1;
+  }
+  //NOTE: ReadMultiFiles takes the headers as one zero separated list.
+  char* RegistryList = (char*)malloc(strlen(Registry) + 1);
+  strcpy(RegistryList, Registry);
+  char* RegistryEnd = RegistryList;
+  for (; *RegistryEnd; ++RegistryEnd)
+  {
+    if (*RegistryEnd == ',')
+    {
+      *RegistryEnd = 0;
+    }
+  }
+  char* ArbData = ReadMultiFiles(RegistryList, RegistryEnd, 0);
+  if (!ArbData)
+  {
+    return 1;
+  }
+  size_t RegistrySize = strlen(ArbData);
+  GLArbToken* ArbHash = (GLArbToken*)calloc(sizeof(GLArbToken), TOKEN_HASH_SIZE);
+  unsigned long long RegistryTokens = 0;
+  unsigned int ArbTokenCount = ParseRegistry(ArbData, ArbHash, &RegistryTokens);
+
+  size_t CorpusSize = 0;
+  char* Corpus = WriteCorpus(&Settings, ArbHash, &CorpusSize);
+  printf("corpus: %d files, %.1f MB, seed %llu (symbols %d%%, comments %d%%, strings %d%%)\n",
+         Settings.FileCount, (double)CorpusSize/(1024.0*1024.0), Settings.Seed,
+         Settings.SymbolDensity, Settings.CommentDensity, Settings.StringDensity);
+  printf("registry: %s, %u tokens, %.1f MB\n\n", Settings.Registry ? Settings.Registry : "synthetic",
+         ArbTokenCount, (double)RegistrySize/(1024.0*1024.0));
+  printf("  %-18s %10s %10s %10s %10s\n", "benchmark", "median ms", "best ms", "MB/s", "rate");
+
+  double* Times = (double*)malloc(sizeof(double)*(size_t)Settings.Iterations);
+  GLString* Tokens = 0;
+  size_t TokenCount = 0;
+  size_t TokenBytes = 0;
+  volatile unsigned int Sink = 0;
+
+  for (int Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    double Start = GetWallClock();
+    size_t Count = 0;
+    GLTokenizer Tokenizer;
+    Tokenizer.At = Corpus;
+    while (*Tokenizer.At)
+    {
+      GLToken Token = ParseToken(&Tokenizer);
+      Sink ^= Token.Hash;
+      Count++;
+    }
+    Times[Iteration] = GetWallClock() - Start;
+    TokenCount = Count;
+  }
+  PrintResult("ParseToken", GetResult(Times, Settings.Iterations), (double)CorpusSize,
+              (double)TokenCount, "tokens");
+
+  Tokens = (GLString*)malloc(sizeof(GLString)*(TokenCount + 1));
+  {
+    size_t Count = 0;
+    GLTokenizer Tokenizer;
+    Tokenizer.At = Corpus;
+    while (*Tokenizer.At)
+    {
+      GLToken Token = ParseToken(&Tokenizer);
+      Tokens[Count++] = Token.Value;
+      TokenBytes += Token.Value.Length;
+    }
+  }
+  for (int Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    double Start = GetWallClock();
+    unsigned int Hash = 0;
+    for (size_t Index = 0; Index < TokenCount; ++Index)
+    {
+      Hash ^= GetStringHash(Tokens[Index]);
+    }
+    Times[Iteration] = GetWallClock() - Start;
+    Sink ^= Hash;
+  }
+  PrintResult("GetStringHash", GetResult(Times, Settings.Iterations), (double)TokenBytes,
+              (double)TokenCount, "hashes");
+
+  unsigned int* Hashes = (unsigned int*)malloc(sizeof(unsigned int)*(TokenCount + 1));
+  for (size_t Index = 0; Index < TokenCount; ++Index)
+  {
+    Hashes[Index] = GetStringHash(Tokens[Index]);
+  }
+  size_t Hits = 0;
+  for (int Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    double Start = GetWallClock();
+    size_t Found = 0;
+    for (size_t Index = 0; Index < TokenCount; ++Index)
+    {
+      Found += GetToken(ArbHash, Hashes[Index]) != 0;
+    }
+    Times[Iteration] = GetWallClock() - Start;
+    Hits = Found;
+  }
+  PrintResult("ArbHash lookup", GetResult(Times, Settings.Iterations), 0.0,
+              (double)TokenCount, "lookups");
+
+  for (int Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    GLArbToken* Hash = (GLArbToken*)calloc(sizeof(GLArbToken), TOKEN_HASH_SIZE);
+    unsigned long long Count = 0;
+    double Start = GetWallClock();
+    ParseRegistry(ArbData, Hash, &Count);
+    Times[Iteration] = GetWallClock() - Start;
+    free(Hash);
+  }
+  PrintResult("registry parse", GetResult(Times, Settings.Iterations), (double)RegistrySize,
+              (double)RegistryTokens, "tokens");
+
+  //NOTE: End to end runs go through the command line like glgen does.
+  int ArgCount = 7 + Settings.FileCount;
+  char** Args = (char**)malloc(sizeof(char*)*(size_t)ArgCount);
+  char Output[1024];
+  snprintf(Output, sizeof(Output), "%s/opengl.generated.h", Settings.Directory);
+  for (int Iteration = 0; Iteration < Settings.Iterations; ++Iteration)
+  {
+    strcpy(RegistryList, Registry);
+    Args[0] = argv[0];
+    Args[1] = (char*)"-silent";
+    Args[2] = (char*)"-force";
+    Args[3] = (char*)"-gl";
+    Args[4] = RegistryList;
+    Args[5] = (char*)"-o";
+    Args[6] = Output;
+    char Paths[1024];
+    for (int Index = 0; Index < Settings.FileCount; ++Index)
+    {
+      snprintf(Paths, sizeof(Paths), "%s/corpus_%04d.cpp", Settings.Directory, Index);
+      Args[7 + Index] = (char*)malloc(strlen(Paths) + 1);
+      strcpy(Args[7 + Index], Paths);
+    }
+    GLSettings GenerateSettings = {};
+    double Start = GetWallClock();
+    if (ParseCommandLine(&GenerateSettings, ArgCount, Args))
+    {
+      GenerateSettings.WriteTimestamp = GetLastWriteTime(Output);
+      GenerateOpenGLHeader(&GenerateSettings);
+    }
+    Times[Iteration] = GetWallClock() - Start;
+    FreeMemory(&GenerateSettings);
+    for (int Index = 0; Index < Settings.FileCount; ++Index)
+    {
+      free(Args[7 + Index]);
+    }
+  }
+  PrintResult("end to end", GetResult(Times, Settings.Iterations), (double)(CorpusSize + RegistrySize),
+              (double)(TokenCount + RegistryTokens), "tokens");
+  printf("\n%zu of %zu corpus tokens found in the registry\n", Hits, TokenCount);
+
+  free(Args);
+  free(Hashes);
+  free(Tokens);
+  free(Times);
+  free(Corpus);
+  free(ArbHash);
+  free(ArbData);
+  free(RegistryList);
+  free(Registry);
+  (void)Sink;
+  return 0;
+}
@@ -0,0 +1,214 @@
+/*
+// hash_bench.cpp - Compares the string hashes glgen can be built with - Public Domain
+//
+// Collects every gl* and GL_* name of the registry headers and reports, for
+// each hash GLGEN_HASH can select, the throughput on those identifiers, the
+// number of 32 bit collisions and the probe lengths in glgen's token table.
+//
+// Example:
+//    glgen_hash_bench glcorearb.h glext.h
+*/
+
+#define GLGEN_NO_MAIN
+#include "../glgen.cpp"
+
+typedef unsigned int (*HashProc)(GLString& String);
+
+struct HashFunction
+{
+  const char* Name;
+  HashProc Hash;
+};
+
+static HashFunction HashFunctions[] =
+{
+  {"fnv1", GetStringHashFNV1},
+  {"fnv1a", GetStringHashFNV1a},
+  {"wy", GetStringHashWy},
+  {GLGEN_CRC32C_HARDWARE ? "crc32c (sse4.2)" : "crc32c (table)", GetStringHashCRC32C},
+};
+
+static
+int CompareNames(const void* A, const void* B)
+{
+  const GLString* First = (const GLString*)A;
+  const GLString* Second = (const GLString*)B;
+  int Result = (First->Length > Second->Length) - (First->Length < Second->Length);
+  if (!Result)
+  {
+    Result = memcmp(First->Chars, Second->Chars, First->Length);
+  }
+  return Result;
+}
+
+static
+int CompareHashes(const void* A, const void* B)
+{
+  unsigned int First = *(const unsigned int*)A;
+  unsigned int Second = *(const unsigned int*)B;
+  return (First > Second) - (First < Second);
+}
+
+// Inserts Hashes into an open addressed table of Size slots the way AddToken
+// does, and counts how far each one ends up from its home slot.
+static
+void SimulateTable(GLTableStats* Stats, unsigned int* Hashes, unsigned int Count, unsigned int Size)
+{
+  unsigned int* Table = (unsigned int*)calloc(Size, sizeof(unsigned int));
+  memset(Stats, 0, sizeof(GLTableStats));
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    unsigned int Slot = Hashes[Index] & (Size - 1);
+    unsigned int Probe = 1;
+    while (Table[Slot] && Table[Slot] != Hashes[Index])
+    {
+      Slot = (Slot + 1) & (Size - 1);
+      Probe++;
+    }
+    if (!Table[Slot])
+    {
+      Table[Slot] = Hashes[Index];
+      unsigned int Bucket = Probe <= 4 ? Probe - 1 : Probe <= 8 ? 4 : Probe <= 16 ? 5 : Probe <= 64 ? 6 : 7;
+      Stats->Used++;
+      Stats->TotalProbes += Probe;
+      Stats->Probes[Bucket]++;
+      if (Probe > Stats->MaxProbe)
+      {
+        Stats->MaxProbe = Probe;
+      }
+    }
+  }
+  free(Table);
+}
+
+static
+void PrintTable(const char* Name, GLTableStats* Stats, unsigned int Size)
+{
+  printf("  %-16s %5u/%-6u mean probe %6.2f, max %5u  ", Name, Stats->Used, Size,
+         Stats->Used ? (double)Stats->TotalProbes/Stats->Used : 0.0, Stats->MaxProbe);
+  for (int Bucket = 0; Bucket < PROBE_BUCKETS; ++Bucket)
+  {
+    printf(" %s:%u", ProbeBucketNames[Bucket], Stats->Probes[Bucket]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s <registryfile> [registryfiles...]\n", argv[0]);
+    return 1;
+  }
+
+  //NOTE: The names glgen hashes are the gl* and GL_* identifiers, each
+  // counted once no matter how many headers declare it.
+  char** Files = (char**)malloc(sizeof(char*)*(size_t)argc);
+  unsigned int Capacity = 1 << 16;
+  unsigned int Count = 0;
+  GLString* Names = (GLString*)malloc(sizeof(GLString)*Capacity);
+  size_t TotalBytes = 0;
+  for (int Index = 1; Index < argc; ++Index)
+  {
+    Files[Index] = ReadEntireFile(argv[Index], 0);
+    if (!Files[Index])
+    {
+      return 1;
+    }
+    GLTokenizer Tokenizer;
+    Tokenizer.At = Files[Index];
+    while (*Tokenizer.At)
+    {
+      GLToken Token = ParseToken(&Tokenizer);
+      if ((StartsWith(Token.Value, "gl") && Token.Value.Length > 2 && IsUpperCase(Token.Value.Chars[2])) ||
+          StartsWith(Token.Value, "GL_"))
+      {
+        if (Count == Capacity)
+        {
+          Capacity *= 2;
+          Names = (GLString*)realloc(Names, sizeof(GLString)*Capacity);
+        }
+        Names[Count++] = Token.Value;
+      }
+    }
+  }
+  qsort(Names, Count, sizeof(GLString), CompareNames);
+  unsigned int Unique = 0;
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    if (!Unique || CompareNames(Names + Unique - 1, Names + Index) != 0)
+    {
+      Names[Unique++] = Names[Index];
+      TotalBytes += Names[Index].Length;
+    }
+  }
+  Count = Unique;
+  unsigned int HalfLoadSize = 1;
+  while (HalfLoadSize < 2*Count)
+  {
+    HalfLoadSize *= 2;
+  }
+  printf("%u unique names, %.1f bytes on average\n\n", Count, (double)TotalBytes/Count);
+
+  unsigned int* Hashes = (unsigned int*)malloc(sizeof(unsigned int)*(Count + 1));
+  const int Rounds = 200;
+  volatile unsigned int Sink = 0;
+  for (unsigned int Function = 0; Function < sizeof(HashFunctions)/sizeof(*HashFunctions); ++Function)
+  {
+    HashFunction* Hash = HashFunctions + Function;
+    double Best = 0;
+    for (int Iteration = 0; Iteration < 5; ++Iteration)
+    {
+      double Start = GetWallClock();
+      for (int Round = 0; Round < Rounds; ++Round)
+      {
+        for (unsigned int Index = 0; Index < Count; ++Index)
+        {
+          Sink += Hash->Hash(Names[Index]);
+        }
+      }
+      double Time = GetWallClock() - Start;
+      Best = (Iteration == 0 || Time < Best) ? Time : Best;
+    }
+    for (unsigned int Index = 0; Index < Count; ++Index)
+    {
+      Hashes[Index] = Hash->Hash(Names[Index]);
+    }
+    GLTableStats Table;
+    GLTableStats HalfLoadTable;
+    SimulateTable(&HalfLoadTable, Hashes, Count, HalfLoadSize);
+    if (Count < TOKEN_HASH_SIZE)
+    {
+      SimulateTable(&Table, Hashes, Count, TOKEN_HASH_SIZE);
+    }
+    qsort(Hashes, Count, sizeof(unsigned int), CompareHashes);
+    unsigned int Collisions = 0;
+    for (unsigned int Index = 1; Index < Count; ++Index)
+    {
+      Collisions += Hashes[Index] == Hashes[Index - 1];
+    }
+
+    double Hashed = (double)Count*Rounds;
+    printf("%s: %.2f ns/hash, %.1f MB/s, %u collisions\n", Hash->Name, Best*1e9/Hashed,
+           (double)TotalBytes*Rounds/Best/(1024.0*1024.0), Collisions);
+    if (Count < TOKEN_HASH_SIZE)
+    {
+      PrintTable("glgen table", &Table, TOKEN_HASH_SIZE);
+    }
+    else
+    {
+      printf("  %-16s doesn't fit %u slots\n", "glgen table", TOKEN_HASH_SIZE);
+    }
+    PrintTable("half load", &HalfLoadTable, HalfLoadSize);
+    printf("\n");
+  }
+
+  free(Hashes);
+  for (int Index = 1; Index < argc; ++Index)
+  {
+    free(Files[Index]);
+  }
+  free(Files);
+  free(Names);
+  return 0;
+}
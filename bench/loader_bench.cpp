@@ -0,0 +1,678 @@
+/*
+// loader_bench.cpp - Startup latency of generated loaders against a stub libGL - Public Domain
+//
+// Writes and builds a stub libGL.so.1 that exports glXGetProcAddressARB and
+// every function of the registry, with a configurable latency per lookup.
+// Then it generates loaders that use N of those functions in each loader
+// mode and runs each one many times as a fresh process. Every run reports
+// the time to dlopen the stub, the time OpenGLInit takes to resolve the
+// functions and query the version, the version query on its own, and the
+// first call of every function. The report gives percentiles of each.
+// Linux only, no GPU needed.
+//
+// Example:
+//    glgen_loader_bench -gl glcorearb.h,glext.h
+//    glgen_loader_bench -gl glcorearb.h -counts 100,1000 -modes default,lazy -latency 500
+*/
+
+#define GLGEN_NO_MAIN
+#include "../glgen.cpp"
+
+#include <limits.h> // PATH_MAX
+
+#ifndef GLGEN_BENCH_COMPILER
+  #define GLGEN_BENCH_COMPILER "c++"
+#endif
+
+#define LOADER_PHASES 4
+
+static const char* LoaderPhaseNames[LOADER_PHASES] =
+{
+  "dlopen", "init", "version", "first call",
+};
+
+struct LoaderBenchSettings
+{
+  const char* Directory;
+  char* Registry;
+  const char* Compiler;
+  const char* Counts;
+  const char* Modes;
+  int Runs;
+  int Latency;
+  int ExtensionPercent;
+};
+
+// Orders names like strcmp, which the stub's binary search relies on.
+static
+int CompareNames(const void* A, const void* B)
+{
+  const GLString* First = (const GLString*)A;
+  const GLString* Second = (const GLString*)B;
+  unsigned int Length = First->Length < Second->Length ? First->Length : Second->Length;
+  int Result = memcmp(First->Chars, Second->Chars, Length);
+  if (!Result)
+  {
+    Result = (First->Length > Second->Length) - (First->Length < Second->Length);
+  }
+  return Result;
+}
+
+static
+int CompareFunctions(const void* A, const void* B)
+{
+  return CompareNames(&(*(GLArbToken* const*)A)->FunctionName, &(*(GLArbToken* const*)B)->FunctionName);
+}
+
+static
+int CompareDoubles(const void* A, const void* B)
+{
+  double First = *(const double*)A;
+  double Second = *(const double*)B;
+  return (First > Second) - (First < Second);
+}
+
+// Nearest rank percentile of sorted Times.
+static
+double GetPercentile(double* Times, int Count, int Percent)
+{
+  int Index = (Count*Percent + 99)/100 - 1;
+  Index = Index < 0 ? 0 : Index >= Count ? Count - 1 : Index;
+  return Times[Index];
+}
+
+// The registry parse also picks up a few words of comments as functions.
+static
+int IsFunctionName(GLString Name)
+{
+  int Result = StartsWith(Name, "gl");
+  for (unsigned int Index = 0; Result && Index < Name.Length; ++Index)
+  {
+    Result = isalnum((unsigned char)Name.Chars[Index]) || Name.Chars[Index] == '_';
+  }
+  return Result;
+}
+
+static
+int IsStubSpecial(GLString Name)
+{
+  return Equal(Name, "glGetString") || Equal(Name, "glGetStringi") ||
+         Equal(Name, "glGetIntegerv");
+}
+
+// Writes the stub libGL source. Every registry function is an empty export,
+// glGetString, glGetStringi and glGetIntegerv report OpenGL 4.6 with the first
+// Extensions extensions, and glXGetProcAddressARB spins for
+// GLGEN_STUB_LATENCY_NS before it looks the name up.
+static
+int WriteStub(const char* Path, GLArbToken** Functions, unsigned int FunctionCount,
+              GLString* Extensions, unsigned int ExtensionCount)
+{
+  FILE* File = fopen(Path, "w");
+  if (!File)
+  {
+    fprintf(stderr, "Couldn't open file %s\n", Path);
+    return 0;
+  }
+  fprintf(File,
+          "// Stub libGL.so.1 written by glgen_loader_bench.\n"
+          "#include <stdlib.h>\n"
+          "#include <string.h>\n"
+          "#include <time.h>\n"
+          "\n"
+          "extern \"C\"\n"
+          "{\n"
+          "typedef void (*GLStubProc)(void);\n"
+          "\n"
+          "int GLStubLookups;\n"
+          "\n"
+          "static const char* GLStubExtensions[%u] =\n"
+          "{\n", ExtensionCount + 1);
+  for (unsigned int Index = 0; Index < ExtensionCount; ++Index)
+  {
+    fprintf(File, "  \"%" PRI_STR "\",\n", Extensions[Index].Length, Extensions[Index].Chars);
+  }
+  fprintf(File,
+          "  0,\n"
+          "};\n"
+          "\n"
+          "const unsigned char* glGetString(unsigned int Name)\n"
+          "{\n"
+          "  return (const unsigned char*)(Name == 0x1F00 ? \"glgen\" : Name == 0x1F01 ? \"stub\" :\n"
+          "                                Name == 0x1F02 ? \"4.6.0 stub\" : Name == 0x1F03 ? \"\" : 0);\n"
+          "}\n"
+          "\n"
+          "const unsigned char* glGetStringi(unsigned int Name, unsigned int Index)\n"
+          "{\n"
+          "  return (const unsigned char*)(Name == 0x1F03 && Index < %uu ? GLStubExtensions[Index] : 0);\n"
+          "}\n"
+          "\n"
+          "void glGetIntegerv(unsigned int Name, int* Data)\n"
+          "{\n"
+          "  if (Data && (Name == 0x821B || Name == 0x821C || Name == 0x821D))\n"
+          "  {\n"
+          "    *Data = Name == 0x821B ? 4 : Name == 0x821C ? 6 : %u;\n"
+          "  }\n"
+          "}\n"
+          "\n", ExtensionCount, ExtensionCount);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLString Name = Functions[Index]->FunctionName;
+    if (!IsStubSpecial(Name))
+    {
+      fprintf(File, "void %" PRI_STR "(void) {}\n", Name.Length, Name.Chars);
+    }
+  }
+  fprintf(File, "\nstatic const char* GLStubNames[%u] =\n{\n", FunctionCount);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLString Name = Functions[Index]->FunctionName;
+    fprintf(File, "  \"%" PRI_STR "\",\n", Name.Length, Name.Chars);
+  }
+  fprintf(File, "};\n\nstatic const GLStubProc GLStubProcs[%u] =\n{\n", FunctionCount);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLString Name = Functions[Index]->FunctionName;
+    fprintf(File, "  (GLStubProc)%" PRI_STR ",\n", Name.Length, Name.Chars);
+  }
+  fprintf(File,
+          "};\n"
+          "\n"
+          "GLStubProc glXGetProcAddressARB(const unsigned char* Name)\n"
+          "{\n"
+          "  static long long Latency = -1;\n"
+          "  if (Latency < 0)\n"
+          "  {\n"
+          "    const char* Value = getenv(\"GLGEN_STUB_LATENCY_NS\");\n"
+          "    Latency = Value ? atoll(Value) : 0;\n"
+          "  }\n"
+          "  GLStubLookups++;\n"
+          "  if (Latency > 0)\n"
+          "  {\n"
+          "    struct timespec Start, Now;\n"
+          "    clock_gettime(CLOCK_MONOTONIC, &Start);\n"
+          "    do\n"
+          "    {\n"
+          "      clock_gettime(CLOCK_MONOTONIC, &Now);\n"
+          "    } while ((Now.tv_sec - Start.tv_sec)*1000000000ll + (Now.tv_nsec - Start.tv_nsec) < Latency);\n"
+          "  }\n"
+          "  int Low = 0;\n"
+          "  int High = %u - 1;\n"
+          "  while (Low <= High)\n"
+          "  {\n"
+          "    int Middle = (Low + High)/2;\n"
+          "    int Order = strcmp((const char*)Name, GLStubNames[Middle]);\n"
+          "    if (!Order)\n"
+          "    {\n"
+          "      return GLStubProcs[Middle];\n"
+          "    }\n"
+          "    if (Order < 0)\n"
+          "    {\n"
+          "      High = Middle - 1;\n"
+          "    }\n"
+          "    else\n"
+          "    {\n"
+          "      Low = Middle + 1;\n"
+          "    }\n"
+          "  }\n"
+          "  return 0;\n"
+          "}\n"
+          "}\n", FunctionCount);
+  fclose(File);
+  return 1;
+}
+
+// Writes the input glgen scans for a loader of the Count functions in Used.
+static
+int WriteLoaderInput(const char* Path, GLArbToken** Used, unsigned int Count)
+{
+  FILE* File = fopen(Path, "w");
+  if (!File)
+  {
+    fprintf(stderr, "Couldn't open file %s\n", Path);
+    return 0;
+  }
+  fprintf(File, "void UseOpenGL()\n{\n  glGetString();\n  glGetStringi();\n  glGetIntegerv();\n");
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    GLString Name = Used[Index]->FunctionName;
+    fprintf(File, "  %" PRI_STR "();\n", Name.Length, Name.Chars);
+  }
+  fprintf(File, "}\n");
+  fclose(File);
+  return 1;
+}
+
+// Writes the program that times one start of the loader in Header and prints
+// the phases in seconds, the stub lookups and the version. The first calls pass
+// zero for every parameter, so lazy stubs forward real arguments.
+static
+int WriteLoaderTimer(const char* Path, const char* Header, GLArbToken** Used, unsigned int Count)
+{
+  FILE* File = fopen(Path, "w");
+  if (!File)
+  {
+    fprintf(stderr, "Couldn't open file %s\n", Path);
+    return 0;
+  }
+  const char* Generated =
+    "#include \"%s\"\n"
+    "#include <stdio.h>\n"
+    "#include <time.h>\n"
+    "\n"
+    "static double GetTime()\n"
+    "{\n"
+    "  struct timespec Time;\n"
+    "  clock_gettime(CLOCK_MONOTONIC, &Time);\n"
+    "  return (double)Time.tv_sec + (double)Time.tv_nsec*1e-9;\n"
+    "}\n"
+    "\n"
+    "%s"
+    "\n"
+    "int main()\n"
+    "{\n"
+    "  double Start = GetTime();\n"
+    "  LoadOpenGL();\n"
+    "  double Loaded = GetTime();\n"
+    "  OpenGLVersion Version;\n"
+    "  OpenGLInit(&Version);\n"
+    "  double Initialized = GetTime();\n"
+    "  volatile unsigned long long Identity = GEN_GetDriverIdentity();\n"
+    "  GLint Major = 0;\n"
+    "  GLint Minor = 0;\n"
+    "  glGetIntegerv(GL_MAJOR_VERSION, &Major);\n"
+    "  glGetIntegerv(GL_MINOR_VERSION, &Minor);\n"
+    "  double Queried = GetTime();\n"
+    "  CallFunctions();\n"
+    "  double Called = GetTime();\n"
+    "  int* Lookups = (int*)dlsym(OpenGLHandle, \"GLStubLookups\");\n"
+    "  printf(\"%%.9f %%.9f %%.9f %%.9f %%d %%d.%%d\\n\", Loaded - Start, Initialized - Loaded,\n"
+    "         Queried - Initialized, Called - Queried, Lookups ? *Lookups : -1, Major, Minor);\n"
+    "  (void)Identity;\n"
+    "  (void)Version;\n"
+    "  return 0;\n"
+    "}\n";
+  //NOTE: Functions of features the stub doesn't report stay null.
+  size_t CallsSize = 64 + (size_t)Count*(3*128 + 3*MAX_PARAMETERS);
+  char* Calls = (char*)malloc(CallsSize);
+  char* At = Calls;
+  At += sprintf(At, "static void CallFunctions()\n{\n");
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    GLString Name = Used[Index]->FunctionName;
+    GLParameter Parameters[MAX_PARAMETERS];
+    int ParameterCount = GetParameters(Used[Index]->Parameters, Parameters);
+    At += sprintf(At, "  if (GEN_PROCS[GEN_ID_%" PRI_STR "])\n    %" PRI_STR "(",
+                  Name.Length, Name.Chars, Name.Length, Name.Chars);
+    for (int Parameter = 0; Parameter < ParameterCount; ++Parameter)
+    {
+      At += sprintf(At, "%s0", Parameter ? ", " : "");
+    }
+    At += sprintf(At, ");\n");
+  }
+  sprintf(At, "}\n");
+  fprintf(File, Generated, Header, Calls);
+  free(Calls);
+  fclose(File);
+  return 1;
+}
+
+static
+int RunCommand(const char* Command)
+{
+  int Result = system(Command);
+  if (Result != 0)
+  {
+    fprintf(stderr, "Command failed: %s\n", Command);
+  }
+  return Result == 0;
+}
+
+// Generates the loader of Count functions for Mode with glgen itself, and
+// builds its timer. Mode is "default" or glgen options without the dash
+// joined by '+', e.g. "lazy+features".
+static
+int BuildLoader(LoaderBenchSettings* Settings, char* Program, const char* Registry,
+                const char* Input, GLArbToken** Used, unsigned int Count, const char* Mode)
+{
+  char Header[PATH_MAX];
+  char Timer[PATH_MAX];
+  if (snprintf(Header, sizeof(Header), "%s/loader_%u_%s.h", Settings->Directory, Count, Mode) >= (int)sizeof(Header) ||
+      snprintf(Timer, sizeof(Timer), "%s/loader_%u_%s.cpp", Settings->Directory, Count, Mode) >= (int)sizeof(Timer) ||
+      snprintf(Program, PATH_MAX, "%s/loader_%u_%s", Settings->Directory, Count, Mode) >= PATH_MAX)
+  {
+    fprintf(stderr, "Path too long in %s\n", Settings->Directory);
+    return 0;
+  }
+
+  char Options[256];
+  snprintf(Options, sizeof(Options), "%s", strcmp(Mode, "default") == 0 ? "" : Mode);
+  char* Args[64];
+  char* RegistryList = (char*)malloc(strlen(Registry) + 1);
+  strcpy(RegistryList, Registry);
+  int ArgCount = 0;
+  Args[ArgCount++] = (char*)"glgen";
+  Args[ArgCount++] = (char*)"-silent";
+  Args[ArgCount++] = (char*)"-force";
+  Args[ArgCount++] = (char*)"-gl";
+  Args[ArgCount++] = RegistryList;
+  Args[ArgCount++] = (char*)"-o";
+  Args[ArgCount++] = Header;
+  //NOTE: main is walking the counts with strtok, the options are split by hand.
+  char Flags[64][64];
+  for (char* Option = Options; *Option && ArgCount < 62;)
+  {
+    char* End = strchr(Option, '+');
+    End = End ? End : Option + strlen(Option);
+    snprintf(Flags[ArgCount], sizeof(Flags[ArgCount]), "-%.*s", (int)(End - Option), Option);
+    Args[ArgCount] = Flags[ArgCount];
+    ArgCount++;
+    Option = *End ? End + 1 : End;
+  }
+  Args[ArgCount++] = (char*)Input;
+
+  int Result = 0;
+  GLSettings GenerateSettings = {};
+  if (ParseCommandLine(&GenerateSettings, ArgCount, Args))
+  {
+    Result = GenerateOpenGLHeader(&GenerateSettings) == 0;
+  }
+  FreeMemory(&GenerateSettings);
+  free(RegistryList);
+  if (!Result)
+  {
+    fprintf(stderr, "Couldn't generate %s\n", Header);
+    return 0;
+  }
+  char Name[PATH_MAX];
+  snprintf(Name, sizeof(Name), "loader_%u_%s.h", Count, Mode);
+  char Command[4*PATH_MAX];
+  if (snprintf(Command, sizeof(Command), "%s -O2 -o \"%s\" \"%s\" -ldl",
+               Settings->Compiler, Program, Timer) >= (int)sizeof(Command))
+  {
+    fprintf(stderr, "Command too long for %s\n", Program);
+    return 0;
+  }
+  return WriteLoaderTimer(Timer, Name, Used, Count) && RunCommand(Command);
+}
+
+// Runs Program Settings->Runs times after a warm up run and prints the
+// percentiles of every phase in microseconds.
+static
+void RunLoader(LoaderBenchSettings* Settings, const char* Program, unsigned int Count, const char* Mode)
+{
+  double* Times[LOADER_PHASES];
+  for (int Phase = 0; Phase < LOADER_PHASES; ++Phase)
+  {
+    Times[Phase] = (double*)malloc(sizeof(double)*(size_t)Settings->Runs);
+  }
+  int Lookups = 0;
+  int Runs = 0;
+  char Version[32] = "?";
+  for (int Run = -1; Run < Settings->Runs; ++Run)
+  {
+    FILE* Pipe = popen(Program, "r");
+    double Phases[LOADER_PHASES];
+    int Major = 0;
+    int Minor = 0;
+    int Read = Pipe ? fscanf(Pipe, "%lf %lf %lf %lf %d %d.%d", Phases, Phases + 1, Phases + 2,
+                             Phases + 3, &Lookups, &Major, &Minor) : 0;
+    if (Pipe)
+    {
+      pclose(Pipe);
+    }
+    if (Read != 7)
+    {
+      fprintf(stderr, "%s didn't report its timings\n", Program);
+      break;
+    }
+    snprintf(Version, sizeof(Version), "%d.%d", Major, Minor);
+    if (Run >= 0)
+    {
+      for (int Phase = 0; Phase < LOADER_PHASES; ++Phase)
+      {
+        Times[Phase][Runs] = Phases[Phase];
+      }
+      Runs++;
+    }
+  }
+  if (Runs)
+  {
+    printf("  %9u %-16s %7d %7s", Count, Mode, Lookups, Version);
+    for (int Phase = 0; Phase < LOADER_PHASES; ++Phase)
+    {
+      qsort(Times[Phase], (size_t)Runs, sizeof(double), CompareDoubles);
+      char Percentiles[64];
+      snprintf(Percentiles, sizeof(Percentiles), "%.1f/%.1f/%.1f",
+               GetPercentile(Times[Phase], Runs, 50)*1e6, GetPercentile(Times[Phase], Runs, 90)*1e6,
+               GetPercentile(Times[Phase], Runs, 99)*1e6);
+      printf(" %22s", Percentiles);
+    }
+    printf("\n");
+  }
+  for (int Phase = 0; Phase < LOADER_PHASES; ++Phase)
+  {
+    free(Times[Phase]);
+  }
+}
+
+static
+void PrintBenchHelp(char** argv)
+{
+  printf("Usage: %s -gl <file1>,<file2> [options]\n", argv[0]);
+  printf("\noptional arguments:\n");
+  printf("  %-20s Directory for the stub and the loaders (default glgen_loader_bench)\n", "-dir <directory>");
+  printf("  %-20s Compiler for the stub and the loaders (default %s)\n", "-cc <compiler>", GLGEN_BENCH_COMPILER);
+  printf("  %-20s Functions each loader uses (default 50,100,250,500,1000,2000,3000)\n", "-counts <n1>,<n2>");
+  printf("  %-20s Loader modes, glgen options joined by + (default default,lazy,features,fallbacks)\n", "-modes <m1>,<m2>");
+  printf("  %-20s Process starts per loader (default 50)\n", "-runs <count>");
+  printf("  %-20s Latency of every glXGetProcAddressARB in ns (default 0)\n", "-latency <ns>");
+  printf("  %-20s Percentage of the registry's extensions the stub reports (default 100)\n", "-extensions <percent>");
+}
+
+int main(int argc, char** argv)
+{
+  LoaderBenchSettings Settings = {};
+  Settings.Directory = "glgen_loader_bench";
+  Settings.Compiler = GLGEN_BENCH_COMPILER;
+  Settings.Counts = "50,100,250,500,1000,2000,3000";
+  Settings.Modes = "default,lazy,features,fallbacks";
+  Settings.Runs = 50;
+  Settings.ExtensionPercent = 100;
+  for (int Index = 1; Index < argc; ++Index)
+  {
+    const char* Option = argv[Index];
+    const char* Value = Index + 1 < argc ? argv[Index + 1] : 0;
+    if (!Value || Option[0] != '-')
+    {
+      PrintBenchHelp(argv);
+      return 1;
+    }
+    if (strcmp(Option, "-dir") == 0)
+    {
+      Settings.Directory = Value;
+    }
+    else if (strcmp(Option, "-gl") == 0)
+    {
+      Settings.Registry = (char*)Value;
+    }
+    else if (strcmp(Option, "-cc") == 0)
+    {
+      Settings.Compiler = Value;
+    }
+    else if (strcmp(Option, "-counts") == 0)
+    {
+      Settings.Counts = Value;
+    }
+    else if (strcmp(Option, "-modes") == 0)
+    {
+      Settings.Modes = Value;
+    }
+    else if (strcmp(Option, "-runs") == 0)
+    {
+      Settings.Runs = atoi(Value);
+    }
+    else if (strcmp(Option, "-latency") == 0)
+    {
+      Settings.Latency = atoi(Value);
+    }
+    else if (strcmp(Option, "-extensions") == 0)
+    {
+      Settings.ExtensionPercent = atoi(Value);
+    }
+    else
+    {
+      PrintBenchHelp(argv);
+      return 1;
+    }
+    Index++;
+  }
+  if (!Settings.Registry || Settings.Runs < 1 || Settings.Latency < 0 ||
+      Settings.ExtensionPercent < 0 || Settings.ExtensionPercent > 100)
+  {
+    PrintBenchHelp(argv);
+    return 1;
+  }
+  mkdir(Settings.Directory, 0755);
+
+  //NOTE: ReadMultiFiles takes the headers as one zero separated list.
+  char* RegistryList = (char*)malloc(strlen(Settings.Registry) + 1);
+  strcpy(RegistryList, Settings.Registry);
+  char* RegistryEnd = RegistryList;
+  for (; *RegistryEnd; ++RegistryEnd)
+  {
+    if (*RegistryEnd == ',')
+    {
+      *RegistryEnd = 0;
+    }
+  }
+  char* ArbData = ReadMultiFiles(RegistryList, RegistryEnd, 0);
+  if (!ArbData)
+  {
+    return 1;
+  }
+  GLArbToken* ArbHash = (GLArbToken*)calloc(sizeof(GLArbToken), TOKEN_HASH_SIZE);
+  unsigned long long RegistryTokens = 0;
+  ParseRegistry(ArbData, ArbHash, &RegistryTokens);
+
+  GLArbToken** Functions = (GLArbToken**)malloc(sizeof(GLArbToken*)*TOKEN_HASH_SIZE);
+  GLArbToken** Used = (GLArbToken**)malloc(sizeof(GLArbToken*)*TOKEN_HASH_SIZE);
+  GLString* Extensions = (GLString*)malloc(sizeof(GLString)*TOKEN_HASH_SIZE);
+  unsigned int FunctionCount = 0;
+  unsigned int ExtensionCount = 0;
+  for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+  {
+    GLArbToken* Token = ArbHash + Index;
+    if (Token->Hash && IsFunctionName(Token->FunctionName))
+    {
+      Functions[FunctionCount++] = Token;
+      if (Token->FeatureIndex && IsExtensionName(Token->Feature))
+      {
+        Extensions[ExtensionCount++] = Token->Feature;
+      }
+    }
+  }
+  qsort(Functions, FunctionCount, sizeof(GLArbToken*), CompareFunctions);
+  qsort(Extensions, ExtensionCount, sizeof(GLString), CompareNames);
+  unsigned int Unique = 0;
+  for (unsigned int Index = 0; Index < ExtensionCount; ++Index)
+  {
+    if (!Unique || CompareNames(Extensions + Unique - 1, Extensions + Index) != 0)
+    {
+      Extensions[Unique++] = Extensions[Index];
+    }
+  }
+  ExtensionCount = Unique;
+  unsigned int Reported = (unsigned int)((unsigned long long)ExtensionCount*Settings.ExtensionPercent/100);
+
+  char Directory[PATH_MAX];
+  if (!realpath(Settings.Directory, Directory))
+  {
+    fprintf(stderr, "Couldn't find directory %s\n", Settings.Directory);
+    return 1;
+  }
+  char Path[PATH_MAX];
+  char Command[4*PATH_MAX];
+  if (snprintf(Path, sizeof(Path), "%s/libGL.cpp", Directory) >= (int)sizeof(Path) ||
+      snprintf(Command, sizeof(Command), "%s -O2 -shared -fPIC -o \"%s/libGL.so.1\" \"%s\"",
+               Settings.Compiler, Directory, Path) >= (int)sizeof(Command))
+  {
+    fprintf(stderr, "Path too long in %s\n", Directory);
+    return 1;
+  }
+  if (!WriteStub(Path, Functions, FunctionCount, Extensions, Reported) || !RunCommand(Command))
+  {
+    return 1;
+  }
+  //NOTE: The loaders dlopen libGL.so.1 by name, so the stub has to come first.
+  char Latency[32];
+  snprintf(Latency, sizeof(Latency), "%d", Settings.Latency);
+  setenv("LD_LIBRARY_PATH", Directory, 1);
+  setenv("GLGEN_STUB_LATENCY_NS", Latency, 1);
+
+  printf("stub libGL: %u functions, %u of %u extensions, %d ns per lookup, %d runs\n\n",
+         FunctionCount, Reported, ExtensionCount, Settings.Latency, Settings.Runs);
+  printf("  %9s %-16s %7s %7s", "functions", "mode", "lookups", "version");
+  for (int Phase = 0; Phase < LOADER_PHASES; ++Phase)
+  {
+    char Title[64];
+    snprintf(Title, sizeof(Title), "%s p50/90/99 us", LoaderPhaseNames[Phase]);
+    printf(" %22s", Title);
+  }
+  printf("\n");
+
+  char* Counts = (char*)malloc(strlen(Settings.Counts) + 1);
+  strcpy(Counts, Settings.Counts);
+  unsigned int Previous = 0;
+  for (char* CountValue = strtok(Counts, ","); CountValue; CountValue = strtok(0, ","))
+  {
+    unsigned int Count = (unsigned int)atoi(CountValue);
+    Count = Count < FunctionCount ? Count : FunctionCount;
+    if (!Count || Count == Previous)
+    {
+      continue;
+    }
+    Previous = Count;
+    char Input[PATH_MAX];
+    if (snprintf(Input, sizeof(Input), "%s/loader_%u.cpp", Directory, Count) >= (int)sizeof(Input))
+    {
+      fprintf(stderr, "Path too long in %s\n", Directory);
+      return 1;
+    }
+    //NOTE: The functions are spread evenly over the sorted registry, so every
+    // version and extension block contributes.
+    for (unsigned int Index = 0; Index < Count; ++Index)
+    {
+      Used[Index] = Functions[(unsigned long long)Index*FunctionCount/Count];
+    }
+    if (!WriteLoaderInput(Input, Used, Count))
+    {
+      return 1;
+    }
+    //NOTE: The counts are split with strtok, so the modes are split by hand.
+    for (const char* Mode = Settings.Modes; *Mode;)
+    {
+      const char* End = strchr(Mode, ',');
+      End = End ? End : Mode + strlen(Mode);
+      char Name[128];
+      snprintf(Name, sizeof(Name), "%.*s", (int)(End - Mode), Mode);
+      Mode = *End ? End + 1 : End;
+      char Program[PATH_MAX];
+      LoaderBenchSettings LoaderSettings = Settings;
+      LoaderSettings.Directory = Directory;
+      if (BuildLoader(&LoaderSettings, Program, Settings.Registry, Input, Used, Count, Name))
+      {
+        RunLoader(&Settings, Program, Count, Name);
+      }
+    }
+  }
+
+  free(Counts);
+  free(Functions);
+  free(Used);
+  free(Extensions);
+  free(ArbHash);
+  free(ArbData);
+  free(RegistryList);
+  return 0;
+}
@@ -0,0 +1,373 @@
+/*
+// stub_gl.cpp - Stub libGL.so.1 the checks of generated loaders run against - Public Domain
+//
+// Exports glXGetProcAddressARB and the functions the checks use. Every lookup
+// and call is counted, names are handed out in order, and programs get a fake
+// binary that glProgramBinary only accepts on the renderer it came from.
+// Linux only, no GPU needed. See stub_gl.h.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define STUB_MAX_PROGRAMS 1024
+#define STUB_BINARY_FORMAT 0x7357u
+
+enum
+{
+  GLStub_glGetString,
+  GLStub_glGetStringi,
+  GLStub_glGetIntegerv,
+  GLStub_glGetError,
+  GLStub_glClear,
+  GLStub_glDrawArrays,
+  GLStub_glUseProgram,
+  GLStub_glBindBuffer,
+  GLStub_glBindTexture,
+  GLStub_glActiveTexture,
+  GLStub_glBindVertexArray,
+  GLStub_glEnable,
+  GLStub_glDisable,
+  GLStub_glBlendFunc,
+  GLStub_glDepthFunc,
+  GLStub_glViewport,
+  GLStub_glGenBuffers,
+  GLStub_glDeleteBuffers,
+  GLStub_glGenTextures,
+  GLStub_glDeleteTextures,
+  GLStub_glGenVertexArrays,
+  GLStub_glDeleteVertexArrays,
+  GLStub_glCreateProgram,
+  GLStub_glDeleteProgram,
+  GLStub_glCreateShader,
+  GLStub_glDeleteShader,
+  GLStub_glShaderSource,
+  GLStub_glCompileShader,
+  GLStub_glAttachShader,
+  GLStub_glLinkProgram,
+  GLStub_glProgramParameteri,
+  GLStub_glGetProgramiv,
+  GLStub_glGetProgramBinary,
+  GLStub_glProgramBinary,
+  GLStub_glBlendEquation,
+  GLStub_glBindFramebuffer,
+  GLStub_glPixelStorei,
+  GLStub_glUniform4fv,
+  GLStub_glTexSubImage2D,
+  GLStub_glVertexAttribPointer,
+  GLStubFunctionCount
+};
+
+extern "C"
+{
+long GLStubLookups;
+__thread long GLStubThreadLookups;
+long long GLStubLookupLatency;
+long long GLStubCallLatency;
+const char* GLStubRenderer = "stub";
+unsigned long long GLStubDataHash;
+const void* GLStubPixelOffset;
+const void* GLStubAttribPointer;
+
+static long GLStubCounts[GLStubFunctionCount];
+static unsigned int GLStubNextName = 1;
+static int GLStubLinked[STUB_MAX_PROGRAMS];
+static int GLStubUnpackAlignment = 4;
+static unsigned int GLStubUnpackBuffer;
+
+static void GLStubSpin(long long Nanoseconds)
+{
+  if (Nanoseconds > 0)
+  {
+    struct timespec Start, Now;
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    do
+    {
+      clock_gettime(CLOCK_MONOTONIC, &Now);
+    } while ((Now.tv_sec - Start.tv_sec)*1000000000ll + (Now.tv_nsec - Start.tv_nsec) < Nanoseconds);
+  }
+}
+
+static void GLStubCount(int Function)
+{
+  __atomic_fetch_add(GLStubCounts + Function, 1, __ATOMIC_RELAXED);
+}
+
+// Folds client memory a call read into GLStubDataHash with FNV-1a.
+static void GLStubHash(const void* Data, size_t Size)
+{
+  for (size_t Index = 0; Index < Size; ++Index)
+  {
+    GLStubDataHash = (GLStubDataHash ^ ((const unsigned char*)Data)[Index])*1099511628211ull;
+  }
+}
+
+static void GLStubGenerate(int Function, int Count, unsigned int* Names)
+{
+  GLStubCount(Function);
+  GLStubSpin(GLStubCallLatency);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    Names[Index] = __atomic_fetch_add(&GLStubNextName, 1, __ATOMIC_RELAXED);
+  }
+}
+
+static void GLStubDelete(int Function)
+{
+  GLStubCount(Function);
+  GLStubSpin(GLStubCallLatency);
+}
+
+// The fake binary of a program names the renderer it was linked on.
+static int GLStubGetBinary(char* Binary, size_t Size)
+{
+  return snprintf(Binary, Size, "stub binary linked on %s", GLStubRenderer) + 1;
+}
+
+const unsigned char* glGetString(unsigned int Name)
+{
+  GLStubCount(GLStub_glGetString);
+  return (const unsigned char*)(Name == 0x1F00 ? "glgen" : Name == 0x1F01 ? GLStubRenderer :
+                                Name == 0x1F02 ? "4.6.0 stub" : Name == 0x1F03 ? "" : 0);
+}
+
+const unsigned char* glGetStringi(unsigned int Name, unsigned int Index)
+{
+  (void)Name;
+  (void)Index;
+  GLStubCount(GLStub_glGetStringi);
+  return 0;
+}
+
+void glGetIntegerv(unsigned int Name, int* Data)
+{
+  GLStubCount(GLStub_glGetIntegerv);
+  if (Data)
+  {
+    *Data = Name == 0x821B ? 4 : Name == 0x821C ? 6 : Name == 0x0CF5 ? GLStubUnpackAlignment :
+            Name == 0x88EF ? (int)GLStubUnpackBuffer : 0;
+  }
+}
+
+unsigned int glGetError()
+{
+  GLStubCount(GLStub_glGetError);
+  return 0;
+}
+
+void glClear(unsigned int) { GLStubCount(GLStub_glClear); }
+void glDrawArrays(unsigned int, int, int) { GLStubCount(GLStub_glDrawArrays); }
+void glUseProgram(unsigned int) { GLStubCount(GLStub_glUseProgram); }
+void glBindTexture(unsigned int, unsigned int) { GLStubCount(GLStub_glBindTexture); }
+void glActiveTexture(unsigned int) { GLStubCount(GLStub_glActiveTexture); }
+void glBindVertexArray(unsigned int) { GLStubCount(GLStub_glBindVertexArray); }
+void glEnable(unsigned int) { GLStubCount(GLStub_glEnable); }
+void glDisable(unsigned int) { GLStubCount(GLStub_glDisable); }
+void glBlendFunc(unsigned int, unsigned int) { GLStubCount(GLStub_glBlendFunc); }
+void glDepthFunc(unsigned int) { GLStubCount(GLStub_glDepthFunc); }
+void glViewport(int, int, int, int) { GLStubCount(GLStub_glViewport); }
+void glBlendEquation(unsigned int) { GLStubCount(GLStub_glBlendEquation); }
+void glBindFramebuffer(unsigned int, unsigned int) { GLStubCount(GLStub_glBindFramebuffer); }
+
+void glBindBuffer(unsigned int Target, unsigned int Buffer)
+{
+  GLStubCount(GLStub_glBindBuffer);
+  if (Target == 0x88EC) // GL_PIXEL_UNPACK_BUFFER
+  {
+    GLStubUnpackBuffer = Buffer;
+  }
+}
+
+void glPixelStorei(unsigned int Name, int Value)
+{
+  GLStubCount(GLStub_glPixelStorei);
+  if (Name == 0x0CF5) // GL_UNPACK_ALIGNMENT
+  {
+    GLStubUnpackAlignment = Value;
+  }
+}
+
+void glUniform4fv(int, int Count, const float* Value)
+{
+  GLStubCount(GLStub_glUniform4fv);
+  GLStubHash(Value, (size_t)Count*4*sizeof(*Value));
+}
+
+// Reads rows of Width GL_RGB or GL_RGBA bytes at the unpack alignment, or
+// takes Pixels as an offset while a GL_PIXEL_UNPACK_BUFFER is bound.
+void glTexSubImage2D(unsigned int, int, int, int, int Width, int Height, unsigned int Format,
+                     unsigned int, const void* Pixels)
+{
+  GLStubCount(GLStub_glTexSubImage2D);
+  if (GLStubUnpackBuffer)
+  {
+    GLStubPixelOffset = Pixels;
+  }
+  else
+  {
+    size_t Row = (size_t)Width*(Format == 0x1907 ? 3 : 4);
+    size_t Alignment = (size_t)GLStubUnpackAlignment;
+    size_t Stride = (Row + Alignment - 1)/Alignment*Alignment;
+    for (int Y = 0; Y < Height; ++Y)
+    {
+      GLStubHash((const unsigned char*)Pixels + Y*Stride, Row);
+    }
+  }
+}
+
+void glVertexAttribPointer(unsigned int, int, unsigned int, unsigned char, int, const void* Pointer)
+{
+  GLStubCount(GLStub_glVertexAttribPointer);
+  GLStubAttribPointer = Pointer;
+}
+
+void glGenBuffers(int Count, unsigned int* Names) { GLStubGenerate(GLStub_glGenBuffers, Count, Names); }
+void glDeleteBuffers(int, const unsigned int*) { GLStubDelete(GLStub_glDeleteBuffers); }
+void glGenTextures(int Count, unsigned int* Names) { GLStubGenerate(GLStub_glGenTextures, Count, Names); }
+void glDeleteTextures(int, const unsigned int*) { GLStubDelete(GLStub_glDeleteTextures); }
+void glGenVertexArrays(int Count, unsigned int* Names) { GLStubGenerate(GLStub_glGenVertexArrays, Count, Names); }
+void glDeleteVertexArrays(int, const unsigned int*) { GLStubDelete(GLStub_glDeleteVertexArrays); }
+
+unsigned int glCreateProgram()
+{
+  unsigned int Result;
+  GLStubGenerate(GLStub_glCreateProgram, 1, &Result);
+  return Result;
+}
+
+unsigned int glCreateShader(unsigned int)
+{
+  unsigned int Result;
+  GLStubGenerate(GLStub_glCreateShader, 1, &Result);
+  return Result;
+}
+
+void glDeleteProgram(unsigned int) { GLStubDelete(GLStub_glDeleteProgram); }
+void glDeleteShader(unsigned int) { GLStubDelete(GLStub_glDeleteShader); }
+void glShaderSource(unsigned int, int Count, const char* const* Strings, const int* Lengths)
+{
+  GLStubCount(GLStub_glShaderSource);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    GLStubHash(Strings[Index], Lengths && Lengths[Index] >= 0 ? (size_t)Lengths[Index] : strlen(Strings[Index]));
+  }
+}
+void glCompileShader(unsigned int) { GLStubCount(GLStub_glCompileShader); }
+void glAttachShader(unsigned int, unsigned int) { GLStubCount(GLStub_glAttachShader); }
+void glProgramParameteri(unsigned int, unsigned int, int) { GLStubCount(GLStub_glProgramParameteri); }
+
+void glLinkProgram(unsigned int Program)
+{
+  GLStubCount(GLStub_glLinkProgram);
+  if (Program < STUB_MAX_PROGRAMS)
+  {
+    GLStubLinked[Program] = 1;
+  }
+}
+
+void glGetProgramiv(unsigned int Program, unsigned int Name, int* Value)
+{
+  GLStubCount(GLStub_glGetProgramiv);
+  int Linked = Program < STUB_MAX_PROGRAMS && GLStubLinked[Program];
+  *Value = 0;
+  if (Name == 0x8B82) // GL_LINK_STATUS
+  {
+    *Value = Linked;
+  }
+  else if (Name == 0x8741 && Linked) // GL_PROGRAM_BINARY_LENGTH
+  {
+    *Value = GLStubGetBinary(0, 0);
+  }
+}
+
+void glGetProgramBinary(unsigned int Program, int Size, int* Length, unsigned int* Format, void* Binary)
+{
+  GLStubCount(GLStub_glGetProgramBinary);
+  int Written = 0;
+  if (Program < STUB_MAX_PROGRAMS && GLStubLinked[Program] && Size >= GLStubGetBinary(0, 0))
+  {
+    Written = GLStubGetBinary((char*)Binary, (size_t)Size);
+    *Format = STUB_BINARY_FORMAT;
+  }
+  if (Length)
+  {
+    *Length = Written;
+  }
+}
+
+void glProgramBinary(unsigned int Program, unsigned int Format, const void* Binary, int Length)
+{
+  GLStubCount(GLStub_glProgramBinary);
+  char Expected[256];
+  int ExpectedLength = GLStubGetBinary(Expected, sizeof(Expected));
+  if (Program < STUB_MAX_PROGRAMS)
+  {
+    GLStubLinked[Program] = Format == STUB_BINARY_FORMAT && Length == ExpectedLength &&
+                            memcmp(Binary, Expected, (size_t)Length) == 0;
+  }
+}
+
+typedef void (*GLStubProc)(void);
+
+static const char* GLStubNames[GLStubFunctionCount] =
+{
+  "glGetString", "glGetStringi", "glGetIntegerv", "glGetError", "glClear", "glDrawArrays",
+  "glUseProgram", "glBindBuffer", "glBindTexture", "glActiveTexture", "glBindVertexArray",
+  "glEnable", "glDisable", "glBlendFunc", "glDepthFunc", "glViewport",
+  "glGenBuffers", "glDeleteBuffers", "glGenTextures", "glDeleteTextures",
+  "glGenVertexArrays", "glDeleteVertexArrays",
+  "glCreateProgram", "glDeleteProgram", "glCreateShader", "glDeleteShader", "glShaderSource",
+  "glCompileShader", "glAttachShader", "glLinkProgram", "glProgramParameteri",
+  "glGetProgramiv", "glGetProgramBinary", "glProgramBinary", "glBlendEquation", "glBindFramebuffer",
+  "glPixelStorei", "glUniform4fv", "glTexSubImage2D", "glVertexAttribPointer",
+};
+
+static const GLStubProc GLStubProcs[GLStubFunctionCount] =
+{
+  (GLStubProc)glGetString, (GLStubProc)glGetStringi, (GLStubProc)glGetIntegerv,
+  (GLStubProc)glGetError, (GLStubProc)glClear, (GLStubProc)glDrawArrays,
+  (GLStubProc)glUseProgram, (GLStubProc)glBindBuffer, (GLStubProc)glBindTexture,
+  (GLStubProc)glActiveTexture, (GLStubProc)glBindVertexArray,
+  (GLStubProc)glEnable, (GLStubProc)glDisable, (GLStubProc)glBlendFunc,
+  (GLStubProc)glDepthFunc, (GLStubProc)glViewport,
+  (GLStubProc)glGenBuffers, (GLStubProc)glDeleteBuffers, (GLStubProc)glGenTextures,
+  (GLStubProc)glDeleteTextures, (GLStubProc)glGenVertexArrays, (GLStubProc)glDeleteVertexArrays,
+  (GLStubProc)glCreateProgram, (GLStubProc)glDeleteProgram, (GLStubProc)glCreateShader,
+  (GLStubProc)glDeleteShader, (GLStubProc)glShaderSource, (GLStubProc)glCompileShader,
+  (GLStubProc)glAttachShader, (GLStubProc)glLinkProgram, (GLStubProc)glProgramParameteri,
+  (GLStubProc)glGetProgramiv, (GLStubProc)glGetProgramBinary, (GLStubProc)glProgramBinary,
+  (GLStubProc)glBlendEquation, (GLStubProc)glBindFramebuffer,
+  (GLStubProc)glPixelStorei, (GLStubProc)glUniform4fv, (GLStubProc)glTexSubImage2D,
+  (GLStubProc)glVertexAttribPointer,
+};
+
+static int GLStubFind(const char* Name)
+{
+  int Result = -1;
+  for (int Index = 0; Index < GLStubFunctionCount; ++Index)
+  {
+    if (strcmp(Name, GLStubNames[Index]) == 0)
+    {
+      Result = Index;
+      break;
+    }
+  }
+  return Result;
+}
+
+GLStubProc glXGetProcAddressARB(const unsigned char* Name)
+{
+  __atomic_fetch_add(&GLStubLookups, 1, __ATOMIC_RELAXED);
+  GLStubThreadLookups++;
+  GLStubSpin(GLStubLookupLatency);
+  int Function = GLStubFind((const char*)Name);
+  return Function >= 0 ? GLStubProcs[Function] : 0;
+}
+
+long GLStubCalls(const char* Name)
+{
+  int Function = GLStubFind(Name);
+  return Function >= 0 ? __atomic_load_n(GLStubCounts + Function, __ATOMIC_RELAXED) : -1;
+}
+}
@@ -0,0 +1,58 @@
+/*
+// stub_gl.h - Counters of the stub libGL the checks run against - Public Domain
+//
+// The checks link bench/stub_gl.cpp, built as libGL.so.1, so the loaders
+// they generate dlopen the stub instead of a driver. The stub reports OpenGL
+// 4.6 on renderer GLStubRenderer and counts every lookup and call.
+*/
+
+#ifndef GLGEN_STUB_GL_H
+#define GLGEN_STUB_GL_H
+
+#include <stdio.h>
+#include <time.h>
+
+extern "C"
+{
+// Lookups through glXGetProcAddressARB by all threads and by the calling one.
+extern long GLStubLookups;
+extern __thread long GLStubThreadLookups;
+
+// Nanoseconds every lookup and every call that creates or deletes names
+// spins for, to model a slow driver. Zero by default.
+extern long long GLStubLookupLatency;
+extern long long GLStubCallLatency;
+
+// What glGetString(GL_RENDERER) returns. Program binaries only link on the
+// renderer they were retrieved from.
+extern const char* GLStubRenderer;
+
+// FNV-1a hash of the client memory glShaderSource, glUniform4fv and
+// glTexSubImage2D read, and the offsets the last glTexSubImage2D with a
+// GL_PIXEL_UNPACK_BUFFER bound and glVertexAttribPointer got.
+extern unsigned long long GLStubDataHash;
+extern const void* GLStubPixelOffset;
+extern const void* GLStubAttribPointer;
+
+// Number of times the stub function Name was called.
+long GLStubCalls(const char* Name);
+}
+
+// Prints What and whether Condition held. Returns non zero if it didn't.
+static inline
+int Check(int Condition, const char* What)
+{
+  printf("%s %s\n", Condition ? "ok  " : "FAIL", What);
+  return !Condition;
+}
+
+// Seconds of the monotonic clock.
+static inline
+double GetTime()
+{
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (double)Time.tv_sec + (double)Time.tv_nsec*1e-9;
+}
+
+#endif
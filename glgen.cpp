@@ -27,8 +27,18 @@
   #define WIN32_LEAN_AND_MEAN 1
   #define VC_EXTRALEAN 1
   #include <windows.h> // GetFileAttributesEx
+  #include <psapi.h> // GetProcessMemoryInfo
+  #pragma comment(lib, "psapi.lib")
 #else
   #include <sys/stat.h> // stat
+  #include <sys/resource.h> // getrusage
+  #include <time.h> // clock_gettime
+  #include <unistd.h> // getpid
+#if __APPLE__
+  #include <pthread.h> // pthread_threadid_np
+#elif __linux__
+  #include <sys/syscall.h> // SYS_gettid
+#endif
 #endif
 
 struct GLSettings
@@ -45,6 +55,63 @@ struct GLSettings
   int Boilerplate;
   int Silent;
   int ForceGenerate;
+  int Lazy;
+  int Async;
+  int Dispatch;
+  int Wrappers;
+  int Instrument;
+  int Capture;
+  int StateCache;
+  int Commands;
+  int Features;
+  int Fallbacks;
+  int Shared;
+  int Pools;
+  int DeferDelete;
+  int ProgramCache;
+  int Locations;
+  char* StatsFile;
+  char* TraceFile;
+};
+
+enum GLPhase
+{
+  PhaseRegistryRead,
+  PhaseRegistryParse,
+  PhaseInputRead,
+  PhaseInputScan,
+  PhaseSort,
+  PhaseEmit,
+  PhaseCount,
+};
+
+// Probe lengths 1, 2, 3, 4, 5-8, 9-16, 17-64 and above.
+#define PROBE_BUCKETS 8
+
+struct GLTableStats
+{
+  unsigned int Used;
+  unsigned int MaxProbe;
+  unsigned long long TotalProbes;
+  unsigned int Probes[PROBE_BUCKETS];
+};
+
+// Where glgen spends its time, filled when -stats or -trace is given.
+struct GLStats
+{
+  FILE* Trace;
+  int TraceEvents;
+  double Wall[PhaseCount];
+  double Cpu[PhaseCount];
+  double WallStart;
+  double CpuStart;
+  unsigned int FilesRead;
+  unsigned long long BytesRead;
+  unsigned long long RegistryTokens;
+  unsigned long long InputTokens;
+  GLTableStats ArbHash;
+  GLTableStats FunctionsHash;
+  GLTableStats DefinesHash;
 };
 
 static
@@ -56,9 +123,21 @@ int GenerateOpenGLHeader(GLSettings* Settings);
 static
 unsigned long long GetLastWriteTime(const char* Filename);
 
+static
+double GetWallClock();
+
+static
+double GetCpuClock();
+
+static
+unsigned long long GetPeakMemory();
+
 static
 void FreeMemory(GLSettings* Settings);
 
+//NOTE: Define GLGEN_NO_MAIN to build glgen into another program, like the
+// benchmarks in bench/.
+#ifndef GLGEN_NO_MAIN
 static
 void PrintHelp(char** argv)
 {
@@ -74,6 +153,23 @@ void PrintHelp(char** argv)
   printf("  %-20s Function prefix for boilerplate code.\n", "-p <prefix>");
   printf("  %-20s Ignored tokens (comma separated).\n", "-i <token1,token2>");
   printf("  %-20s Don't generate OpenGL loading boilerplate code\n", "-no-b");
+  printf("  %-20s Resolve functions on first call instead of in OpenGLInit\n", "-lazy");
+  printf("  %-20s Generate OpenGLInitAsync to resolve functions on a worker thread\n", "-async");
+  printf("  %-20s Generate per-context OpenGLDispatch tables selected per thread\n", "-dispatch");
+  printf("  %-20s Generate static inline wrapper functions instead of macros\n", "-wrappers");
+  printf("  %-20s Count and time calls in the wrappers (implies -wrappers)\n", "-instrument");
+  printf("  %-20s Record calls to a binary trace and replay it (implies -wrappers)\n", "-capture");
+  printf("  %-20s Skip binding and state calls that change nothing (implies -wrappers)\n", "-statecache");
+  printf("  %-20s Record calls on any thread into command buffers (implies -wrappers)\n", "-commands");
+  printf("  %-20s Resolve only functions of versions and extensions the context supports\n", "-features");
+  printf("  %-20s Point functions the driver lacks at stubs that return zero\n", "-fallbacks");
+  printf("  %-20s Let modules reloaded at runtime bind to the table resolved by the host\n", "-shared");
+  printf("  %-20s Hand out glGen*/glCreate* names from pools filled in bulk (implies -wrappers)\n", "-pools");
+  printf("  %-20s Queue glDelete* calls and make them frames later (implies -wrappers)\n", "-deferdelete");
+  printf("  %-20s Cache linked program binaries on disk when glProgramBinary is used\n", "-programcache");
+  printf("  %-20s Cache locations of uniform and attribute names passed as literals\n", "-locations");
+  printf("  %-20s Report time per phase and table statistics, and write them as JSON\n", "-stats <filename>");
+  printf("  %-20s Write the phases and input files as Chrome trace events\n", "-trace <filename>");
 }
 
 int main(int argc, char** argv)
@@ -115,6 +211,7 @@ int main(int argc, char** argv)
 
   return Result;
 }
+#endif
 
 static
 unsigned long long GetLastWriteTime(const char* Filename)
@@ -144,6 +241,100 @@ unsigned long long GetLastWriteTime(const char* Filename)
   return Result;
 }
 
+// Seconds since an arbitrary point in time.
+static
+double GetWallClock()
+{
+  double Result = 0;
+#if _MSC_VER
+  LARGE_INTEGER Counter;
+  LARGE_INTEGER Frequency;
+  QueryPerformanceCounter(&Counter);
+  QueryPerformanceFrequency(&Frequency);
+  Result = (double)Counter.QuadPart/(double)Frequency.QuadPart;
+#else
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  Result = (double)Time.tv_sec + (double)Time.tv_nsec*1e-9;
+#endif
+  return Result;
+}
+
+// Seconds of CPU time used by the process.
+static
+double GetCpuClock()
+{
+  double Result = 0;
+#if _MSC_VER
+  FILETIME Creation, Exit, Kernel, User;
+  if (GetProcessTimes(GetCurrentProcess(), &Creation, &Exit, &Kernel, &User))
+  {
+    unsigned long long Ticks = ((unsigned long long)Kernel.dwHighDateTime << 32 | Kernel.dwLowDateTime) +
+                               ((unsigned long long)User.dwHighDateTime << 32 | User.dwLowDateTime);
+    Result = (double)Ticks*1e-7;
+  }
+#else
+  struct timespec Time;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Time);
+  Result = (double)Time.tv_sec + (double)Time.tv_nsec*1e-9;
+#endif
+  return Result;
+}
+
+// Peak resident set size in bytes.
+static
+unsigned long long GetPeakMemory()
+{
+  unsigned long long Result = 0;
+#if _MSC_VER
+  PROCESS_MEMORY_COUNTERS Counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+  {
+    Result = Counters.PeakWorkingSetSize;
+  }
+#else
+  struct rusage Usage;
+  if (getrusage(RUSAGE_SELF, &Usage) == 0)
+  {
+#if __APPLE__
+    Result = (unsigned long long)Usage.ru_maxrss;
+#else
+    Result = (unsigned long long)Usage.ru_maxrss*1024;
+#endif
+  }
+#endif
+  return Result;
+}
+
+// ID of the process as the system tools show it.
+static
+unsigned long long GetProcessIdentifier()
+{
+#if _MSC_VER
+  unsigned long long Result = GetCurrentProcessId();
+#else
+  unsigned long long Result = (unsigned long long)getpid();
+#endif
+  return Result;
+}
+
+// ID of the calling thread as the system tools show it.
+static
+unsigned long long GetThreadIdentifier()
+{
+  unsigned long long Result = 0;
+#if _MSC_VER
+  Result = GetCurrentThreadId();
+#elif __APPLE__
+  pthread_threadid_np(0, &Result);
+#elif __linux__
+  Result = (unsigned long long)syscall(SYS_gettid);
+#else
+  Result = (unsigned long long)getpid();
+#endif
+  return Result;
+}
+
 static
 void FreeMemory(GLSettings* Settings)
 {
@@ -210,6 +401,14 @@ int ParseCommandLine(GLSettings* Settings, int argc, char** argv)
       {
         Settings->Prefix = argv[++Index];
       }
+      else if (strcmp(Option, "stats") == 0 && Index < argc-1)
+      {
+        Settings->StatsFile = argv[++Index];
+      }
+      else if (strcmp(Option, "trace") == 0 && Index < argc-1)
+      {
+        Settings->TraceFile = argv[++Index];
+      }
       else if (strcmp(Option, "force") == 0)
       {
         Settings->ForceGenerate = 1;
@@ -222,6 +421,72 @@ int ParseCommandLine(GLSettings* Settings, int argc, char** argv)
       {
         Settings->Silent = 1;
       }
+      else if (strcmp(Option, "lazy") == 0)
+      {
+        Settings->Lazy = 1;
+      }
+      else if (strcmp(Option, "async") == 0)
+      {
+        Settings->Async = 1;
+      }
+      else if (strcmp(Option, "dispatch") == 0)
+      {
+        Settings->Dispatch = 1;
+      }
+      else if (strcmp(Option, "wrappers") == 0)
+      {
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "instrument") == 0)
+      {
+        Settings->Instrument = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "capture") == 0)
+      {
+        Settings->Capture = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "statecache") == 0)
+      {
+        Settings->StateCache = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "commands") == 0)
+      {
+        Settings->Commands = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "features") == 0)
+      {
+        Settings->Features = 1;
+      }
+      else if (strcmp(Option, "fallbacks") == 0)
+      {
+        Settings->Fallbacks = 1;
+      }
+      else if (strcmp(Option, "shared") == 0)
+      {
+        Settings->Shared = 1;
+      }
+      else if (strcmp(Option, "pools") == 0)
+      {
+        Settings->Pools = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "deferdelete") == 0)
+      {
+        Settings->DeferDelete = 1;
+        Settings->Wrappers = 1;
+      }
+      else if (strcmp(Option, "programcache") == 0)
+      {
+        Settings->ProgramCache = 1;
+      }
+      else if (strcmp(Option, "locations") == 0)
+      {
+        Settings->Locations = 1;
+      }
       else if (strcmp(Option, "i") == 0)
       {
         Ignores = argv[++Index];
@@ -362,6 +627,9 @@ struct GLArbToken
   GLString ReturnType;
   GLString FunctionName;
   GLString Parameters;
+  GLString Feature;
+  unsigned int FeatureIndex;
+  struct GLArbToken* PoolDelete;
   unsigned int Hash;
 };
 
@@ -370,6 +638,18 @@ struct GLTokenizer
   char* At;
 };
 
+#define MAX_LOCATION_NAMES 512
+
+// Uniform and attribute names the inputs pass as string literals to
+// glGetUniformLocation and glGetAttribLocation.
+struct GLLocations
+{
+  GLString Uniforms[MAX_LOCATION_NAMES];
+  GLString Attributes[MAX_LOCATION_NAMES];
+  unsigned int UniformCount;
+  unsigned int AttributeCount;
+};
+
 static inline
 int IsWhitespace(char c)
 {
@@ -402,8 +682,27 @@ int IsIdentifier(char c)
   return Result;
 }
 
+//NOTE: Tokens are told apart by their 32 bit hash alone and zero marks an
+// empty slot, so every hash has to be collision free over the registry and
+// never return zero. GLGEN_HASH picks the hash at build time.
+#define GLGEN_HASH_FNV1 0
+#define GLGEN_HASH_FNV1A 1
+#define GLGEN_HASH_WY 2
+#define GLGEN_HASH_CRC32C 3
+#ifndef GLGEN_HASH
+#define GLGEN_HASH GLGEN_HASH_FNV1
+#endif
+
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(__AVX__))
+  #include <nmmintrin.h> // _mm_crc32_u64
+  #define GLGEN_CRC32C_HARDWARE 1
+#else
+  #define GLGEN_CRC32C_HARDWARE 0
+#endif
+
+// FNV-1 seeded with 1, glgen's original hash.
 static inline
-unsigned int GetStringHash(GLString& String)
+unsigned int GetStringHashFNV1(GLString& String)
 {
   unsigned int Result = 1;
   unsigned char* RawStr = (unsigned char*)String.Chars;
@@ -415,6 +714,115 @@ unsigned int GetStringHash(GLString& String)
   return Result;
 }
 
+static inline
+unsigned int GetStringHashFNV1a(GLString& String)
+{
+  unsigned int Result = 2166136261u;
+  unsigned char* RawStr = (unsigned char*)String.Chars;
+  for(unsigned int Idx = 0; Idx < String.Length; ++Idx)
+  {
+    Result ^= (unsigned int)*RawStr++;
+    Result *= 0x01000193U;
+  }
+  return Result ? Result : 1;
+}
+
+// Folds the 128 bit product of A and B to 64 bits.
+static inline
+unsigned long long HashMix(unsigned long long A, unsigned long long B)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 Product = (unsigned __int128)A*B;
+  return (unsigned long long)Product ^ (unsigned long long)(Product >> 64);
+#else
+  unsigned long long AHigh = A >> 32, ALow = A & 0xFFFFFFFFull;
+  unsigned long long BHigh = B >> 32, BLow = B & 0xFFFFFFFFull;
+  unsigned long long LowLow = ALow*BLow, LowHigh = ALow*BHigh;
+  unsigned long long HighLow = AHigh*BLow, HighHigh = AHigh*BHigh;
+  unsigned long long Middle = (LowLow >> 32) + (LowHigh & 0xFFFFFFFFull) + (HighLow & 0xFFFFFFFFull);
+  unsigned long long Low = (Middle << 32) | (LowLow & 0xFFFFFFFFull);
+  unsigned long long High = HighHigh + (LowHigh >> 32) + (HighLow >> 32) + (Middle >> 32);
+  return Low ^ High;
+#endif
+}
+
+// wyhash style: eight bytes at a time, each mixed in with a 64x64 bit multiply.
+static inline
+unsigned int GetStringHashWy(GLString& String)
+{
+  const unsigned long long Secret0 = 0xa0761d6478bd642full;
+  const unsigned long long Secret1 = 0xe7037ed1a0b428dbull;
+  unsigned long long Seed = Secret0 ^ String.Length;
+  const char* At = String.Chars;
+  unsigned int Length = String.Length;
+  do
+  {
+    unsigned long long Word = 0;
+    memcpy(&Word, At, Length < 8 ? Length : 8);
+    Seed = HashMix(Word ^ Secret1, Seed ^ Secret0);
+    At += 8;
+    Length = Length < 8 ? 0 : Length - 8;
+  } while (Length);
+  Seed = HashMix(Seed, String.Length ^ Secret1);
+  unsigned int Result = (unsigned int)(Seed ^ (Seed >> 32));
+  return Result ? Result : 1;
+}
+
+static inline
+unsigned int GetStringHashCRC32C(GLString& String)
+{
+  unsigned int Result = 0xFFFFFFFFu;
+  const char* At = String.Chars;
+  unsigned int Length = String.Length;
+#if GLGEN_CRC32C_HARDWARE
+  for (; Length >= 8; Length -= 8, At += 8)
+  {
+    unsigned long long Word;
+    memcpy(&Word, At, 8);
+    Result = (unsigned int)_mm_crc32_u64(Result, Word);
+  }
+  for (; Length; --Length)
+  {
+    Result = _mm_crc32_u8(Result, (unsigned char)*At++);
+  }
+#else
+  //NOTE: Same polynomial as the SSE 4.2 instruction, a byte at a time.
+  static unsigned int Table[256];
+  if (!Table[1])
+  {
+    for (unsigned int Byte = 0; Byte < 256; ++Byte)
+    {
+      unsigned int Value = Byte;
+      for (int Bit = 0; Bit < 8; ++Bit)
+      {
+        Value = (Value >> 1) ^ (0x82F63B78u & (0u - (Value & 1)));
+      }
+      Table[Byte] = Value;
+    }
+  }
+  for (; Length; --Length)
+  {
+    Result = (Result >> 8) ^ Table[(Result ^ (unsigned char)*At++) & 0xFF];
+  }
+#endif
+  Result = ~Result;
+  return Result ? Result : 1;
+}
+
+static inline
+unsigned int GetStringHash(GLString& String)
+{
+#if GLGEN_HASH == GLGEN_HASH_FNV1A
+  return GetStringHashFNV1a(String);
+#elif GLGEN_HASH == GLGEN_HASH_WY
+  return GetStringHashWy(String);
+#elif GLGEN_HASH == GLGEN_HASH_CRC32C
+  return GetStringHashCRC32C(String);
+#else
+  return GetStringHashFNV1(String);
+#endif
+}
+
 static inline
 void UpperCase(char* Output, GLString& Str)
 {
@@ -508,285 +916,4787 @@ int Equal(GLString Token, const char* Value)
   return Result;
 }
 
-#define TOKEN_HASH_SIZE 8192
-
 static inline
-GLArbToken* AddToken(GLArbToken* TokenHash, GLArbToken& Token)
+GLString TrimString(GLString String)
 {
-  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
-  assert(Index < TOKEN_HASH_SIZE);
-  GLArbToken* Matching = TokenHash + Index;
-
-  int Iterations = 0;
-  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
+  while (String.Length && IsWhitespaceOrNewline(*String.Chars))
   {
-    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
-    Matching = TokenHash + Index;
-  }
-  if (Iterations < TOKEN_HASH_SIZE)
-  {
-    *Matching = Token;
+    String.Chars++;
+    String.Length--;
   }
-  else
+  while (String.Length && IsWhitespaceOrNewline(String.Chars[String.Length-1]))
   {
-    Matching = 0;
+    String.Length--;
   }
-  return Matching;
+  return String;
 }
 
+// Returns the parenthesized parameter list of a registry declaration without
+// the trailing semicolon, e.g. "(GLenum target, GLuint buffer)".
 static inline
-void AdvanceToEndOfLine(GLTokenizer* Tokenizer)
+GLString GetParameterList(GLString Parameters)
 {
-  while(*Tokenizer->At && !IsNewline(*Tokenizer->At))
+  GLString Result = {};
+  for (unsigned int Index = 0; Index < Parameters.Length; ++Index)
   {
-    Tokenizer->At++;
+    if (Parameters.Chars[Index] == '(' && !Result.Chars)
+    {
+      Result.Chars = Parameters.Chars + Index;
+    }
+    else if (Parameters.Chars[Index] == ')' && Result.Chars)
+    {
+      Result.Length = (unsigned int)(Parameters.Chars + Index + 1 - Result.Chars);
+    }
   }
+  return Result;
 }
 
-static inline
-int AddToken(GLToken* TokenHash, GLToken& Token)
+#define MAX_PARAMETERS 32
+
+struct GLParameter
 {
-  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
-  GLToken* Matching = TokenHash + Index;
-  assert(Index < TOKEN_HASH_SIZE);
+  GLString Declaration;
+  GLString Type;
+  GLString Name;
+  int Pointer;
+  int Const;
+};
 
-  int Result = 0;
-  int Iterations = 0;
-  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
+// Splits a registry parameter list into its parameters and returns the number
+// of parameters, e.g. "(GLenum target, const void *data)" gives two.
+static inline
+int GetParameters(GLString Parameters, GLParameter* Output)
+{
+  int Count = 0;
+  GLString List = GetParameterList(Parameters);
+  if (List.Length > 2)
   {
-    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
-    Matching = TokenHash + Index;
+    char* At = List.Chars + 1;
+    char* End = List.Chars + List.Length - 1;
+    while (At < End && Count < MAX_PARAMETERS)
+    {
+      char* Start = At;
+      while (At < End && *At != ',')
+      {
+        At++;
+      }
+      GLString Argument = {Start, (unsigned int)(At - Start)};
+      Argument = TrimString(Argument);
+      GLString Declaration = Argument;
+      while (Argument.Length && Argument.Chars[Argument.Length-1] == ']')
+      {
+        while (Argument.Length && Argument.Chars[Argument.Length-1] != '[')
+        {
+          Argument.Length--;
+        }
+        Argument.Length = Argument.Length ? Argument.Length - 1 : 0;
+        Argument = TrimString(Argument);
+      }
+      unsigned int NameEnd = Argument.Length;
+      unsigned int NameStart = NameEnd;
+      while (NameStart > 0 && IsIdentifier(Argument.Chars[NameStart-1]) &&
+             Argument.Chars[NameStart-1] != '*')
+      {
+        NameStart--;
+      }
+      if (NameStart < NameEnd && !(Count == 0 && NameStart == 0 && Equal(Argument, "void")))
+      {
+        GLParameter* Parameter = Output + Count++;
+        Parameter->Declaration = Declaration;
+        Parameter->Name.Chars = Argument.Chars + NameStart;
+        Parameter->Name.Length = NameEnd - NameStart;
+        Parameter->Type.Chars = Argument.Chars;
+        Parameter->Type.Length = NameStart;
+        Parameter->Type = TrimString(Parameter->Type);
+        Parameter->Pointer = 0;
+        Parameter->Const = 0;
+        for (unsigned int Index = 0; Index < Parameter->Type.Length; ++Index)
+        {
+          Parameter->Pointer += Parameter->Type.Chars[Index] == '*';
+        }
+        Parameter->Const = StartsWith(Parameter->Type, "const ");
+      }
+      At++;
+    }
   }
-  if (Iterations < TOKEN_HASH_SIZE)
+  return Count;
+}
+
+// Writes the comma separated argument names of a registry parameter list to
+// Output, e.g. "target, buffer", and returns the number of arguments.
+static inline
+int GetArgumentNames(GLString Parameters, char* Output)
+{
+  GLParameter Arguments[MAX_PARAMETERS];
+  int Count = GetParameters(Parameters, Arguments);
+  *Output = 0;
+  for (int Index = 0; Index < Count; ++Index)
   {
-    *Matching = Token;
+    Output += sprintf(Output, "%s%" PRI_STR, Index ? ", " : "",
+                      Arguments[Index].Name.Length, Arguments[Index].Name.Chars);
   }
+  return Count;
+}
+
+static inline
+int ReturnsVoid(GLArbToken* ArbToken)
+{
+  GLString ReturnType = TrimString(ArbToken->ReturnType);
+  int Result = ReturnType.Length == 4 && Equal(ReturnType, "void");
   return Result;
 }
 
 static inline
-void AddCustomToken(GLToken* TokenHash, const char* Value)
+int IsType(GLString Type, const char* Value)
 {
-  GLToken Token;
-  GLString String;
-  String.Chars = (char*)Value;
-  String.Length = (unsigned int)strlen(Value);
-  Token.Hash = GetStringHash(String);
-  AddToken(TokenHash, Token);
+  int Result = Type.Length == strlen(Value) && Equal(Type, Value);
+  return Result;
 }
 
+enum GLArgumentKind
+{
+  ArgumentValue,
+  ArgumentString,
+  ArgumentStrings,
+  ArgumentData,
+  ArgumentPixels,
+  ArgumentOffset,
+  ArgumentAddress,
+};
+
 static inline
-GLArbToken* GetToken(GLArbToken* TokenHash, unsigned int Hash)
+int FindParameter(GLParameter* Parameters, int Count, const char* Type, const char* Name)
 {
-  GLArbToken* Matching = 0;
-  if (Hash)
+  int Result = -1;
+  for (int Index = 0; Index < Count; ++Index)
   {
-    unsigned int Index = Hash & (TOKEN_HASH_SIZE - 1);
-    Matching = TokenHash + Index;
-
-    int Iterations = 0;
-    while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
-    {
-      if (Matching->Hash == Hash)
-      {
-        break;
-      }
-      Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
-      Matching = TokenHash + Index;
-    }
-    if (Matching->Hash != Hash)
+    if (IsType(Parameters[Index].Type, Type) && IsType(Parameters[Index].Name, Name))
     {
-      Matching = 0;
+      Result = Index;
+      break;
     }
   }
-  return Matching;
+  return Result;
 }
 
-static inline
-int Contains(GLToken* TokenHash, GLToken& Token)
+// Pointer arguments whose size the signature gets wrong. Clears read a
+// single texel of format and type however much they clear, and four values
+// when clearing GL_COLOR, one otherwise. Parameters are four values for
+// GL_TEXTURE_BORDER_COLOR and GL_TEXTURE_SWIZZLE_RGBA, one otherwise. Debug
+// strings are length bytes unless length is negative, and the rest are
+// arrays with a count that isn't called n or values that aren't one per
+// element.
+static const char* ArgumentSizes[][3] =
 {
-  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
-  GLToken* Matching = TokenHash + Index;
+  {"glClearBufferData", "data", "GEN_TexelSize(format, type)"},
+  {"glClearBufferSubData", "data", "GEN_TexelSize(format, type)"},
+  {"glClearNamedBufferData", "data", "GEN_TexelSize(format, type)"},
+  {"glClearNamedBufferDataEXT", "data", "GEN_TexelSize(format, type)"},
+  {"glClearNamedBufferSubData", "data", "GEN_TexelSize(format, type)"},
+  {"glClearNamedBufferSubDataEXT", "data", "GEN_TexelSize(format, type)"},
+  {"glClearTexImage", "data", "GEN_TexelSize(format, type)"},
+  {"glClearTexSubImage", "data", "GEN_TexelSize(format, type)"},
+  {"glClearBufferfv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glClearBufferiv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glClearBufferuiv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glClearNamedFramebufferfv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glClearNamedFramebufferiv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glClearNamedFramebufferuiv", "value", "(buffer == 0x1800 ? 4 : 1)*sizeof(*value)"},
+  {"glTexParameterfv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glTexParameteriv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glTexParameterIiv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glTexParameterIuiv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glTextureParameterfv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glTextureParameteriv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glTextureParameterIiv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glTextureParameterIuiv", "params", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*params)"},
+  {"glSamplerParameterfv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glSamplerParameteriv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glSamplerParameterIiv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glSamplerParameterIuiv", "param", "(pname == 0x1004 || pname == 0x8E46 ? 4 : 1)*sizeof(*param)"},
+  {"glDebugMessageInsert", "buf", "GEN_StringSize(buf, length)"},
+  {"glDebugMessageInsertARB", "buf", "GEN_StringSize(buf, length)"},
+  {"glDebugMessageInsertAMD", "buf", "GEN_StringSize(buf, length)"},
+  {"glDebugMessageInsertKHR", "buf", "GEN_StringSize(buf, length)"},
+  {"glPushDebugGroup", "message", "GEN_StringSize(message, length)"},
+  {"glPushDebugGroupKHR", "message", "GEN_StringSize(message, length)"},
+  {"glObjectLabel", "label", "GEN_StringSize(label, length)"},
+  {"glObjectLabelKHR", "label", "GEN_StringSize(label, length)"},
+  {"glObjectPtrLabel", "label", "GEN_StringSize(label, length)"},
+  {"glObjectPtrLabelKHR", "label", "GEN_StringSize(label, length)"},
+  {"glShaderSource", "length", "(size_t)count*sizeof(*length)"},
+  {"glCompileShaderIncludeARB", "length", "(size_t)count*sizeof(*length)"},
+  {"glShaderBinary", "shaders", "(size_t)count*sizeof(*shaders)"},
+  {"glShaderBinary", "binary", "(size_t)length"},
+  {"glProgramBinary", "binary", "(size_t)length"},
+  {"glSpecializeShader", "pConstantIndex", "(size_t)numSpecializationConstants*sizeof(*pConstantIndex)"},
+  {"glSpecializeShader", "pConstantValue", "(size_t)numSpecializationConstants*sizeof(*pConstantValue)"},
+  {"glSpecializeShaderARB", "pConstantIndex", "(size_t)numSpecializationConstants*sizeof(*pConstantIndex)"},
+  {"glSpecializeShaderARB", "pConstantValue", "(size_t)numSpecializationConstants*sizeof(*pConstantValue)"},
+  {"glBindBuffersBase", "buffers", "(size_t)count*sizeof(*buffers)"},
+  {"glBindBuffersRange", "buffers", "(size_t)count*sizeof(*buffers)"},
+  {"glBindBuffersRange", "offsets", "(size_t)count*sizeof(*offsets)"},
+  {"glBindBuffersRange", "sizes", "(size_t)count*sizeof(*sizes)"},
+  {"glDeleteSamplers", "samplers", "(size_t)count*sizeof(*samplers)"},
+  {"glBindTextures", "textures", "(size_t)count*sizeof(*textures)"},
+  {"glBindSamplers", "samplers", "(size_t)count*sizeof(*samplers)"},
+  {"glBindImageTextures", "textures", "(size_t)count*sizeof(*textures)"},
+  {"glBindVertexBuffers", "buffers", "(size_t)count*sizeof(*buffers)"},
+  {"glBindVertexBuffers", "offsets", "(size_t)count*sizeof(*offsets)"},
+  {"glBindVertexBuffers", "strides", "(size_t)count*sizeof(*strides)"},
+  {"glVertexArrayVertexBuffers", "buffers", "(size_t)count*sizeof(*buffers)"},
+  {"glVertexArrayVertexBuffers", "offsets", "(size_t)count*sizeof(*offsets)"},
+  {"glVertexArrayVertexBuffers", "strides", "(size_t)count*sizeof(*strides)"},
+  {"glDebugMessageControl", "ids", "(size_t)count*sizeof(*ids)"},
+  {"glDebugMessageControlARB", "ids", "(size_t)count*sizeof(*ids)"},
+  {"glDebugMessageControlKHR", "ids", "(size_t)count*sizeof(*ids)"},
+  {"glInvalidateFramebuffer", "attachments", "(size_t)numAttachments*sizeof(*attachments)"},
+  {"glInvalidateSubFramebuffer", "attachments", "(size_t)numAttachments*sizeof(*attachments)"},
+  {"glInvalidateNamedFramebufferData", "attachments", "(size_t)numAttachments*sizeof(*attachments)"},
+  {"glInvalidateNamedFramebufferSubData", "attachments", "(size_t)numAttachments*sizeof(*attachments)"},
+  {"glViewportArrayv", "v", "(size_t)count*4*sizeof(*v)"},
+  {"glViewportIndexedfv", "v", "4*sizeof(*v)"},
+  {"glScissorArrayv", "v", "(size_t)count*4*sizeof(*v)"},
+  {"glScissorIndexedv", "v", "4*sizeof(*v)"},
+  {"glDepthRangeArrayv", "v", "(size_t)count*2*sizeof(*v)"},
+  {"glMultiDrawArrays", "first", "(size_t)drawcount*sizeof(*first)"},
+  {"glMultiDrawArrays", "count", "(size_t)drawcount*sizeof(*count)"},
+  {"glMultiDrawElements", "count", "(size_t)drawcount*sizeof(*count)"},
+  {"glMultiDrawElements", "indices", "(size_t)drawcount*sizeof(*indices)"},
+  {"glMultiDrawElementsBaseVertex", "count", "(size_t)drawcount*sizeof(*count)"},
+  {"glMultiDrawElementsBaseVertex", "indices", "(size_t)drawcount*sizeof(*indices)"},
+  {"glMultiDrawElementsBaseVertex", "basevertex", "(size_t)drawcount*sizeof(*basevertex)"},
+};
 
+// Number of values per element of the vectors glUniform*, glProgramUniform*
+// and glVertexAttrib* take, from the digits after the prefix: 4 for
+// glUniform4fv, 12 for glUniformMatrix3x4fv and 1 for glUniformHandleui64vARB
+// or the packed glVertexAttribP4uiv. Zero for other functions.
+static
+int GetVectorComponents(GLString Function)
+{
   int Result = 0;
-  int Iterations = 0;
-  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
+  const char* Prefixes[3] = {"glUniform", "glProgramUniform", "glVertexAttrib"};
+  for (int Prefix = 0; Prefix < 3 && !Result; ++Prefix)
   {
-    if (Matching->Hash == Token.Hash)
+    if (StartsWith(Function, Prefixes[Prefix]))
     {
+      const char* At = Function.Chars + strlen(Prefixes[Prefix]);
+      const char* End = Function.Chars + Function.Length;
+      int Matrix = End - At >= 6 && strncmp(At, "Matrix", 6) == 0;
+      At += Matrix ? 6 : (At < End && (*At == 'I' || *At == 'L' || *At == 's'));
       Result = 1;
-      break;
+      if (At < End && *At >= '1' && *At <= '4')
+      {
+        int Rows = *At - '0';
+        int Columns = Rows;
+        if (Matrix && End - At >= 3 && At[1] == 'x' && At[2] >= '1' && At[2] <= '4')
+        {
+          Columns = At[2] - '0';
+        }
+        Result = Matrix ? Rows*Columns : Rows;
+      }
     }
-    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
-    Matching = TokenHash + Index;
   }
   return Result;
 }
 
-int TokenComparer(const void* A, const void* B)
+// Decides how a capture records an argument and writes the C expression for
+// its size to Size.
+// - Strings, and arrays of strings with their count and optional lengths,
+//   are copied whole.
+// - Data are copied with the size in bytes from ArgumentSizes, the count and
+//   vector size of glUniform* and glVertexAttrib*, n elements or size bytes.
+// - Pixels are images of width, height and depth texels or imageSize bytes,
+//   copied unless they are an offset into a bound GL_PIXEL_UNPACK_BUFFER.
+// - Offsets are the pointer, indices and indirect arguments of draws and
+//   vertex attribute setup, which are offsets into bound buffers, and the
+//   sync objects and user pointers the call only passes on.
+// - Addresses are pointers of unknown size. Size is the number of bytes the
+//   call writes through them if the signature says, or empty.
+static
+int GetArgumentKind(GLString Function, GLParameter* Parameters, int Count, int Index, char* Size)
 {
-  GLToken* T1 = (GLToken*)A;
-  GLToken* T2 = (GLToken*)B;
-  int Result = 0;
-  if (T1->Hash > T2->Hash)
+  GLParameter* Parameter = Parameters + Index;
+  GLString Name = Parameter->Name;
+  int Result = ArgumentValue;
+  *Size = 0;
+  if (Parameter->Pointer)
   {
-    Result = -1;
+    Result = ArgumentAddress;
+    int Void = 0;
+    for (unsigned int Char = 0; Char + 4 <= Parameter->Type.Length; ++Char)
+    {
+      Void |= strncmp(Parameter->Type.Chars + Char, "void", 4) == 0;
+    }
+    int Width = FindParameter(Parameters, Count, "GLsizei", "width");
+    int Height = FindParameter(Parameters, Count, "GLsizei", "height");
+    int Depth = FindParameter(Parameters, Count, "GLsizei", "depth");
+    int Format = FindParameter(Parameters, Count, "GLenum", "format") >= 0 &&
+                 FindParameter(Parameters, Count, "GLenum", "type") >= 0;
+    for (unsigned int Entry = 0; Entry < ArraySize(ArgumentSizes); ++Entry)
+    {
+      if (IsType(Function, ArgumentSizes[Entry][0]) && IsType(Name, ArgumentSizes[Entry][1]))
+      {
+        Result = ArgumentData;
+        sprintf(Size, "%s", ArgumentSizes[Entry][2]);
+      }
+    }
+    if (Result == ArgumentAddress && Parameter->Const && IsType(Parameter->Type, "const GLchar *const*"))
+    {
+      int Strings = FindParameter(Parameters, Count, "GLsizei", "count");
+      Strings = Strings >= 0 ? Strings : FindParameter(Parameters, Count, "GLsizei", "uniformCount");
+      int Lengths = FindParameter(Parameters, Count, "const GLint *", "length");
+      if (Strings >= 0)
+      {
+        Result = ArgumentStrings;
+        sprintf(Size, "%" PRI_STR ", %" PRI_STR,
+                Parameters[Strings].Name.Length, Parameters[Strings].Name.Chars,
+                Lengths >= 0 ? Parameters[Lengths].Name.Length : 1,
+                Lengths >= 0 ? Parameters[Lengths].Name.Chars : "0");
+      }
+    }
+    else if (Result == ArgumentAddress && Parameter->Const && Parameter->Pointer == 1)
+    {
+      int Components = Void ? 0 : GetVectorComponents(Function);
+      int Elements = FindParameter(Parameters, Count, "GLsizei", "count");
+      if (IsType(Parameter->Type, "const GLchar *"))
+      {
+        Result = ArgumentString;
+      }
+      else if (Components)
+      {
+        Result = ArgumentData;
+        if (Elements >= 0)
+        {
+          sprintf(Size, "(size_t)count*%d*sizeof(*%" PRI_STR ")", Components, Name.Length, Name.Chars);
+        }
+        else
+        {
+          sprintf(Size, "%d*sizeof(*%" PRI_STR ")", Components, Name.Length, Name.Chars);
+        }
+      }
+      else if (Void && IsType(Name, "pixels") && Width >= 0 && Format)
+      {
+        Result = ArgumentPixels;
+        sprintf(Size, "GEN_UnpackImageSize(width, %s, %s, format, type)",
+                Height >= 0 ? "height" : "1", Depth >= 0 ? "depth" : "1");
+      }
+      else if (Void && FindParameter(Parameters, Count, "GLsizei", "imageSize") >= 0)
+      {
+        Result = ArgumentPixels;
+        sprintf(Size, "(size_t)imageSize");
+      }
+      else if (Void && (IsType(Name, "pointer") || IsType(Name, "indices") || IsType(Name, "indirect") ||
+                        IsType(Name, "ptr") || IsType(Name, "userParam")))
+      {
+        Result = ArgumentOffset;
+      }
+      else if (!Void && FindParameter(Parameters, Count, "GLsizei", "n") >= 0)
+      {
+        Result = ArgumentData;
+        sprintf(Size, "(size_t)n*sizeof(*%" PRI_STR ")", Name.Length, Name.Chars);
+      }
+      else if (FindParameter(Parameters, Count, "GLsizeiptr", "size") >= 0)
+      {
+        Result = ArgumentData;
+        sprintf(Size, "(size_t)size");
+      }
+    }
+    else if (Result == ArgumentAddress && !Parameter->Const)
+    {
+      //NOTE: Only needed to keep replayed writes inside the scratch memory, so
+      // the pack state is left out and rows are assumed 8 byte aligned.
+      if (Void && IsType(Name, "pixels") && Width >= 0 && Format)
+      {
+        sprintf(Size, "GEN_ImageSize(width, %s, %s, format, type, 8, 0, 0)",
+                Height >= 0 ? "height" : "1", Depth >= 0 ? "depth" : "1");
+      }
+      else if ((Void || IsType(Parameter->Type, "GLchar *")) &&
+               FindParameter(Parameters, Count, "GLsizei", "bufSize") >= 0)
+      {
+        sprintf(Size, "(size_t)bufSize");
+      }
+      else if (Void && FindParameter(Parameters, Count, "GLsizeiptr", "size") >= 0)
+      {
+        sprintf(Size, "(size_t)size");
+      }
+      else if (!Void && FindParameter(Parameters, Count, "GLsizei", "n") >= 0)
+      {
+        sprintf(Size, "(size_t)n*sizeof(*%" PRI_STR ")", Name.Length, Name.Chars);
+      }
+    }
   }
-  else if (T2->Hash > T1->Hash)
+  return Result;
+}
+
+// Calls can be deferred to a command buffer when they return nothing, write
+// through no pointer and read only through pointers that are copied or
+// offsets. Where pixels come from and how much of them is read depends on
+// unpack state only the context thread can query, and pointers of unknown
+// size can't be copied, so the recording thread's memory would be read when
+// the buffer is executed.
+static inline
+int IsDeferrable(GLArbToken* ArbToken)
+{
+  GLParameter Parameters[MAX_PARAMETERS];
+  int Count = GetParameters(ArbToken->Parameters, Parameters);
+  int Result = ReturnsVoid(ArbToken);
+  for (int Index = 0; Index < Count; ++Index)
   {
-    Result = 1;
+    char Size[256];
+    int Kind = GetArgumentKind(ArbToken->FunctionName, Parameters, Count, Index, Size);
+    if (Kind == ArgumentPixels || Kind == ArgumentAddress)
+    {
+      Result = 0;
+    }
   }
   return Result;
 }
 
-char* ReadEntireFile(char* Filename)
+// Extension names are GL_, an upper case vendor and a name with at least one
+// word that starts lower case, e.g. GL_ARB_debug_output or GL_OES_EGL_image.
+// Enums like GL_COMPRESSED_RGBA_ASTC_4x4_KHR have lower case letters too, but
+// never at the start of a word.
+static inline
+int IsExtensionName(GLString Name)
 {
-  char* Result = 0;
-  FILE* File = fopen(Filename, "r");
-  if (File)
+  int Result = 0;
+  if (StartsWith(Name, "GL_"))
   {
-    fseek(File, 0, SEEK_END);
-    long long Size = ftell(File);
-    if (Size > 0)
+    unsigned int Index = 3;
+    while (Index < Name.Length &&
+           ((Name.Chars[Index] >= 'A' && Name.Chars[Index] <= 'Z') ||
+            (Name.Chars[Index] >= '0' && Name.Chars[Index] <= '9')))
     {
-      fseek(File, 0, SEEK_SET);
-      Result = (char*)malloc((size_t)(Size + 1));
-      fread(Result, (size_t)Size, 1, File);
-      Result[Size] = 0;
+      ++Index;
     }
-    else
+    if (Index > 3 && Index < Name.Length && Name.Chars[Index] == '_')
     {
-      fprintf(stderr, "File is empty: %s", Filename);
+      for (; Index + 1 < Name.Length && !Result; ++Index)
+      {
+        Result = Name.Chars[Index] == '_' && Name.Chars[Index + 1] >= 'a' && Name.Chars[Index + 1] <= 'z';
+      }
     }
-    fclose(File);
-  }
-  else
-  {
-    fprintf(stderr, "Couldn't open file: %s", Filename);
   }
   return Result;
 }
 
-char* ReadMultiFiles(char* Start, char* End)
+// Registry feature blocks are named after a version, e.g. GL_VERSION_4_5 or
+// GL_ES_VERSION_3_0, or after an extension. Returns the version in Major and
+// Minor, or zero for extensions and other names.
+static inline
+int GetFeatureVersion(GLString Name, int* Major, int* Minor)
 {
-  char* Result = 0;
-  size_t RunningSize = 0;
-  while(Start < End)
+  *Major = 0;
+  *Minor = 0;
+  int Result = 0;
+  for (unsigned int Index = 0; Index + 8 < Name.Length; ++Index)
   {
-    char* Filename = Start;
-    FILE* File = fopen(Filename, "r");
-    if (File)
+    if (strncmp(Name.Chars + Index, "VERSION_", 8) == 0)
     {
-      fseek(File, 0, SEEK_END);
-      long long Size = ftell(File);
-      if (Size > 0)
+      char* At = Name.Chars + Index + 8;
+      char* End = Name.Chars + Name.Length;
+      while (At < End && *At >= '0' && *At <= '9')
       {
-        fseek(File, 0, SEEK_SET);
-        Result = (char*)realloc(Result, (size_t)Size + RunningSize + 1);
-        fread(Result + RunningSize, (size_t)Size, 1, File);
-        Result[RunningSize + (size_t)Size] = 0;
-        if (RunningSize)
-        {
-          Result[RunningSize-2] = '\n';
-          Result[RunningSize-1] = '\n';
-        }
-        RunningSize += (size_t)Size + 1;
+        *Major = *Major*10 + (*At++ - '0');
       }
-      else
+      if (At < End && *At == '_')
       {
-        fprintf(stderr, "File is empty: %s", Filename);
+        ++At;
+        while (At < End && *At >= '0' && *At <= '9')
+        {
+          *Minor = *Minor*10 + (*At++ - '0');
+        }
+        Result = At == End && *Major > 0;
       }
-      fclose(File);
-    }
-    else
-    {
-      fprintf(stderr, "Couldn't open file: %s", Filename);
+      break;
     }
-    Start += strlen(Start) + 1;
   }
   return Result;
 }
 
+static inline
+int IsFeatureName(GLString Name)
+{
+  int Major, Minor;
+  int Result = StartsWith(Name, "GL_") &&
+               (IsExtensionName(Name) || GetFeatureVersion(Name, &Major, &Minor));
+  return Result;
+}
+
+// FNV-1a with a seed, folded so the low bits can index the extension table.
+// The generated GEN_AddExtension computes the same.
+static inline
+unsigned int GetExtensionHash(const char* Name, unsigned int Length, unsigned int Seed)
+{
+  unsigned int Result = 2166136261u ^ Seed;
+  for (unsigned int Index = 0; Index < Length; ++Index)
+  {
+    Result = (Result ^ (unsigned char)Name[Index])*16777619u;
+  }
+  Result ^= Result >> 16;
+  return Result;
+}
+
+#define TOKEN_HASH_SIZE 8192
 
 static inline
-int IsKnownOrIgnoredToken(GLArbToken* ArbHash, GLToken* Token, GLSettings* Settings)
+GLArbToken* AddToken(GLArbToken* TokenHash, GLArbToken& Token)
 {
-  int Found = 0;
-  GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
-  if (ArbToken)
+  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
+  assert(Index < TOKEN_HASH_SIZE);
+  GLArbToken* Matching = TokenHash + Index;
+
+  int Iterations = 0;
+  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
   {
-    Found = 1;
+    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
+    Matching = TokenHash + Index;
+  }
+  if (Iterations < TOKEN_HASH_SIZE)
+  {
+    *Matching = Token;
   }
   else
   {
-    for (int IgnoredIndex = 0; IgnoredIndex < Settings->IgnoreCount; ++IgnoredIndex)
+    Matching = 0;
+  }
+  return Matching;
+}
+
+static inline
+void AdvanceToEndOfLine(GLTokenizer* Tokenizer)
+{
+  while(*Tokenizer->At && !IsNewline(*Tokenizer->At))
+  {
+    Tokenizer->At++;
+  }
+}
+
+static inline
+int AddToken(GLToken* TokenHash, GLToken& Token)
+{
+  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
+  GLToken* Matching = TokenHash + Index;
+  assert(Index < TOKEN_HASH_SIZE);
+
+  int Result = 0;
+  int Iterations = 0;
+  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
+  {
+    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
+    Matching = TokenHash + Index;
+  }
+  if (Iterations < TOKEN_HASH_SIZE)
+  {
+    *Matching = Token;
+  }
+  return Result;
+}
+
+static inline
+void AddCustomToken(GLToken* TokenHash, const char* Value)
+{
+  GLToken Token;
+  GLString String;
+  String.Chars = (char*)Value;
+  String.Length = (unsigned int)strlen(Value);
+  Token.Hash = GetStringHash(String);
+  AddToken(TokenHash, Token);
+}
+
+static inline
+GLArbToken* GetToken(GLArbToken* TokenHash, unsigned int Hash)
+{
+  GLArbToken* Matching = 0;
+  if (Hash)
+  {
+    unsigned int Index = Hash & (TOKEN_HASH_SIZE - 1);
+    Matching = TokenHash + Index;
+
+    int Iterations = 0;
+    while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
     {
-      if (Equal(Token->Value, Settings->Ignores[IgnoredIndex]))
+      if (Matching->Hash == Hash)
       {
-        Found = 1;
         break;
       }
+      Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
+      Matching = TokenHash + Index;
     }
-    if (!Found)
+    if (Matching->Hash != Hash)
     {
-      fprintf(stderr, YELLOW("WARNING") ": Token not found in header: %" PRI_STR "\n",
-             Token->Value.Length, Token->Value.Chars);
+      Matching = 0;
     }
   }
-  return Found;
+  return Matching;
 }
 
 static inline
-int ParseFile(char* Filename, GLArbToken* ArbHash,
-               GLToken* FunctionsHash, unsigned int* FunctionCount,
-               GLToken* DefinesHash, unsigned int* DefinesCount,
-               GLSettings* Settings)
+int Contains(GLToken* TokenHash, GLToken& Token)
 {
-  char* Data = ReadEntireFile(Filename);
-  int Success = 0;
-  if (Data)
+  unsigned int Index = Token.Hash & (TOKEN_HASH_SIZE - 1);
+  GLToken* Matching = TokenHash + Index;
+
+  int Result = 0;
+  int Iterations = 0;
+  while(Matching->Hash && Iterations++ < TOKEN_HASH_SIZE)
   {
-    GLTokenizer Tokenizer;
-    Tokenizer.At = Data;
-    while(*Tokenizer.At)
+    if (Matching->Hash == Token.Hash)
     {
-      GLToken Token = ParseToken(&Tokenizer);
-      if (StartsWith(Token.Value, "gl") && IsUpperCase(Token.Value.Chars[2]))
-      {
-        if (!Contains(FunctionsHash, Token) && IsKnownOrIgnoredToken(ArbHash, &Token, Settings))
-        {
-          AddToken(FunctionsHash, Token);
-          *FunctionCount += 1;
-        }
-      }
-      if (StartsWith(Token.Value, "GL_"))
-      {
-        if (!Contains(DefinesHash, Token) && IsKnownOrIgnoredToken(ArbHash, &Token, Settings))
+      Result = 1;
+      break;
+    }
+    Index = (Index + 1) & (TOKEN_HASH_SIZE - 1);
+    Matching = TokenHash + Index;
+  }
+  return Result;
+}
+
+// Adds a token the generated code needs, unless the inputs already use it.
+static inline
+void AddRequiredToken(GLToken* TokenHash, unsigned int* Count, GLString Value)
+{
+  GLToken Token;
+  Token.Value = Value;
+  Token.Hash = GetStringHash(Token.Value);
+  if (!Contains(TokenHash, Token))
+  {
+    AddToken(TokenHash, Token);
+    *Count += 1;
+  }
+}
+
+static inline
+void AddRequiredToken(GLToken* TokenHash, unsigned int* Count, const char* Value)
+{
+  GLString String;
+  String.Chars = (char*)Value;
+  String.Length = (unsigned int)strlen(Value);
+  AddRequiredToken(TokenHash, Count, String);
+}
+
+// Returns the glDelete* function that frees the names of a glGen* or
+// glCreate* function taking (GLsizei n, GLuint *names), or null for every
+// other function.
+static
+GLArbToken* GetPoolDelete(GLArbToken* ArbHash, GLArbToken* ArbToken)
+{
+  GLArbToken* Result = 0;
+  GLString Name = ArbToken->FunctionName;
+  unsigned int Skip = StartsWith(Name, "glGen") && Name.Length > 5 ? 5 :
+                      StartsWith(Name, "glCreate") && Name.Length > 8 ? 8 : 0;
+  GLParameter Parameters[MAX_PARAMETERS];
+  if (Skip && GetParameters(ArbToken->Parameters, Parameters) == 2 &&
+      IsType(Parameters[0].Type, "GLsizei") && Parameters[1].Pointer == 1 &&
+      !Parameters[1].Const && StartsWith(Parameters[1].Type, "GLuint"))
+  {
+    char Buffer[256];
+    GLString Delete;
+    Delete.Chars = Buffer;
+    Delete.Length = (unsigned int)sprintf(Buffer, "glDelete%" PRI_STR, Name.Length - Skip, Name.Chars + Skip);
+    Result = GetToken(ArbHash, GetStringHash(Delete));
+  }
+  return Result;
+}
+
+enum GLDeleteKind
+{
+  DeleteNone,
+  DeleteNames,
+  DeleteName,
+};
+
+// Deletions can be queued for glDelete* functions taking (GLsizei n,
+// const GLuint *names) or a single GLuint name.
+static
+GLDeleteKind GetDeleteKind(GLArbToken* ArbToken)
+{
+  GLDeleteKind Result = DeleteNone;
+  GLParameter Parameters[MAX_PARAMETERS];
+  if (StartsWith(ArbToken->FunctionName, "glDelete") && ReturnsVoid(ArbToken))
+  {
+    int Count = GetParameters(ArbToken->Parameters, Parameters);
+    if (Count == 2 && IsType(Parameters[0].Type, "GLsizei") &&
+        IsType(Parameters[1].Type, "const GLuint *"))
+    {
+      Result = DeleteNames;
+    }
+    else if (Count == 1 && IsType(Parameters[0].Type, "GLuint"))
+    {
+      Result = DeleteName;
+    }
+  }
+  return Result;
+}
+
+static
+int ContainsText(GLString String, const char* Text)
+{
+  int Result = 0;
+  size_t Length = strlen(Text);
+  for (unsigned int Index = 0; Index + Length <= String.Length && !Result; ++Index)
+  {
+    Result = strncmp(String.Chars + Index, Text, Length) == 0;
+  }
+  return Result;
+}
+
+int TokenComparer(const void* A, const void* B)
+{
+  GLToken* T1 = (GLToken*)A;
+  GLToken* T2 = (GLToken*)B;
+  int Result = 0;
+  if (T1->Hash > T2->Hash)
+  {
+    Result = -1;
+  }
+  else if (T2->Hash > T1->Hash)
+  {
+    Result = 1;
+  }
+  return Result;
+}
+
+// Orders functions by registry feature, keeping the token order within one.
+int FeatureComparer(const void* A, const void* B)
+{
+  GLArbToken* T1 = *(GLArbToken**)A;
+  GLArbToken* T2 = *(GLArbToken**)B;
+  int Result = 0;
+  if (T1->FeatureIndex != T2->FeatureIndex)
+  {
+    Result = T1->FeatureIndex < T2->FeatureIndex ? -1 : 1;
+  }
+  else if (T1->Hash > T2->Hash)
+  {
+    Result = -1;
+  }
+  else if (T2->Hash > T1->Hash)
+  {
+    Result = 1;
+  }
+  return Result;
+}
+
+static const char* PhaseNames[PhaseCount] =
+{
+  "registry_read",
+  "registry_parse",
+  "input_read",
+  "input_scan",
+  "sort",
+  "emit",
+};
+
+static
+void WriteJsonString(FILE* File, const char* String)
+{
+  fputc('"', File);
+  for (const char* At = String; *At; ++At)
+  {
+    if (*At == '"' || *At == '\\')
+    {
+      fputc('\\', File);
+    }
+    fputc(*At, File);
+  }
+  fputc('"', File);
+}
+
+// Writes a complete event to the trace, with the input file and its size as
+// arguments if File is given. Timestamps are monotonic clock microseconds, so
+// traces of several runs on a machine line up.
+static
+void WriteTraceEvent(GLStats* Stats, const char* Name, double Start, double End,
+                     const char* File, unsigned long long Bytes)
+{
+  fprintf(Stats->Trace, "%s\n  {\"name\": \"%s\", \"cat\": \"glgen\", \"ph\": \"X\", "
+                        "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %llu, \"tid\": %llu",
+          Stats->TraceEvents++ ? "," : "", Name, Start*1e6, (End - Start)*1e6,
+          GetProcessIdentifier(), GetThreadIdentifier());
+  if (File)
+  {
+    fprintf(Stats->Trace, ", \"args\": {\"file\": ");
+    WriteJsonString(Stats->Trace, File);
+    fprintf(Stats->Trace, ", \"bytes\": %llu}", Bytes);
+  }
+  fprintf(Stats->Trace, "}");
+}
+
+static inline
+void BeginPhase(GLStats* Stats)
+{
+  if (Stats)
+  {
+    Stats->WallStart = GetWallClock();
+    Stats->CpuStart = GetCpuClock();
+  }
+}
+
+static inline
+void EndPhase(GLStats* Stats, GLPhase Phase)
+{
+  if (Stats)
+  {
+    double End = GetWallClock();
+    Stats->Wall[Phase] += End - Stats->WallStart;
+    Stats->Cpu[Phase] += GetCpuClock() - Stats->CpuStart;
+    if (Stats->Trace)
+    {
+      WriteTraceEvent(Stats, PhaseNames[Phase], Stats->WallStart, End, 0, 0);
+    }
+  }
+}
+
+static inline
+void AddFileRead(GLStats* Stats, long long Size)
+{
+  if (Stats)
+  {
+    Stats->FilesRead++;
+    Stats->BytesRead += (unsigned long long)Size;
+  }
+}
+
+char* ReadEntireFile(char* Filename, GLStats* Stats)
+{
+  char* Result = 0;
+  FILE* File = fopen(Filename, "r");
+  if (File)
+  {
+    fseek(File, 0, SEEK_END);
+    long long Size = ftell(File);
+    if (Size > 0)
+    {
+      fseek(File, 0, SEEK_SET);
+      Result = (char*)malloc((size_t)(Size + 1));
+      fread(Result, (size_t)Size, 1, File);
+      Result[Size] = 0;
+      AddFileRead(Stats, Size);
+    }
+    else
+    {
+      fprintf(stderr, "File is empty: %s", Filename);
+    }
+    fclose(File);
+  }
+  else
+  {
+    fprintf(stderr, "Couldn't open file: %s", Filename);
+  }
+  return Result;
+}
+
+char* ReadMultiFiles(char* Start, char* End, GLStats* Stats)
+{
+  char* Result = 0;
+  size_t RunningSize = 0;
+  while(Start < End)
+  {
+    char* Filename = Start;
+    FILE* File = fopen(Filename, "r");
+    if (File)
+    {
+      fseek(File, 0, SEEK_END);
+      long long Size = ftell(File);
+      if (Size > 0)
+      {
+        fseek(File, 0, SEEK_SET);
+        Result = (char*)realloc(Result, (size_t)Size + RunningSize + 1);
+        fread(Result + RunningSize, (size_t)Size, 1, File);
+        Result[RunningSize + (size_t)Size] = 0;
+        if (RunningSize)
+        {
+          Result[RunningSize-2] = '\n';
+          Result[RunningSize-1] = '\n';
+        }
+        RunningSize += (size_t)Size + 1;
+        AddFileRead(Stats, Size);
+      }
+      else
+      {
+        fprintf(stderr, "File is empty: %s", Filename);
+      }
+      fclose(File);
+    }
+    else
+    {
+      fprintf(stderr, "Couldn't open file: %s", Filename);
+    }
+    Start += strlen(Start) + 1;
+  }
+  return Result;
+}
+
+
+static inline
+int IsKnownOrIgnoredToken(GLArbToken* ArbHash, GLToken* Token, GLSettings* Settings)
+{
+  int Found = 0;
+  GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
+  if (ArbToken)
+  {
+    Found = 1;
+  }
+  else
+  {
+    for (int IgnoredIndex = 0; IgnoredIndex < Settings->IgnoreCount; ++IgnoredIndex)
+    {
+      if (Equal(Token->Value, Settings->Ignores[IgnoredIndex]))
+      {
+        Found = 1;
+        break;
+      }
+    }
+    if (!Found)
+    {
+      fprintf(stderr, YELLOW("WARNING") ": Token not found in header: %" PRI_STR "\n",
+             Token->Value.Length, Token->Value.Chars);
+    }
+  }
+  return Found;
+}
+
+static inline
+int IsLocationNameChar(char C)
+{
+  int Result = (IsIdentifier(C) && C != '#' && C != '*') ||
+               (C == '.') || (C == '[') || (C == ']');
+  return Result;
+}
+
+// Returns the string literal passed as second argument of the call whose
+// argument list starts at At, e.g. uModelView in (Program, "uModelView").
+// The result is empty unless the argument is a literal GLSL name.
+static
+GLString ParseLocationName(char* At)
+{
+  GLString Result = {};
+  while (IsWhitespaceOrNewline(*At))
+  {
+    At++;
+  }
+  if (*At == '(')
+  {
+    int Depth = 0;
+    for (At++; *At && *At != ';' && *At != '"' && Depth >= 0; ++At)
+    {
+      if (*At == ',' && !Depth)
+      {
+        break;
+      }
+      Depth += (*At == '(') - (*At == ')');
+    }
+    if (*At == ',')
+    {
+      At++;
+      while (IsWhitespaceOrNewline(*At))
+      {
+        At++;
+      }
+      if (*At == '"')
+      {
+        char* Start = ++At;
+        while (IsLocationNameChar(*At))
+        {
+          At++;
+        }
+        char* End = At;
+        if (*At++ == '"' && End > Start)
+        {
+          while (IsWhitespaceOrNewline(*At))
+          {
+            At++;
+          }
+          if (*At == ')')
+          {
+            Result.Chars = Start;
+            Result.Length = (unsigned int)(End - Start);
+          }
+        }
+      }
+    }
+  }
+  return Result;
+}
+
+// Turns a GLSL name like lights[0].color into lights_0_color.
+static
+void GetLocationEnumName(char* Output, GLString Name)
+{
+  for (unsigned int Index = 0; Index < Name.Length; ++Index)
+  {
+    char C = Name.Chars[Index];
+    if (C != ']')
+    {
+      *Output++ = (C == '.' || C == '[') ? '_' : C;
+    }
+  }
+  *Output = 0;
+}
+
+// Adds a copy of Name unless it is known already. Names that would get the
+// same enum value as a known one are left out.
+static
+void AddLocationName(GLString* Names, unsigned int* Count, GLString Name)
+{
+  char EnumName[512];
+  char KnownEnumName[512];
+  int Known = Name.Length >= sizeof(EnumName);
+  if (!Known)
+  {
+    GetLocationEnumName(EnumName, Name);
+  }
+  for (unsigned int Index = 0; Index < *Count && !Known; ++Index)
+  {
+    GetLocationEnumName(KnownEnumName, Names[Index]);
+    Known = strcmp(EnumName, KnownEnumName) == 0;
+    if (Known && (Names[Index].Length != Name.Length ||
+                  memcmp(Names[Index].Chars, Name.Chars, Name.Length) != 0))
+    {
+      fprintf(stderr, YELLOW("WARNING") ": Location name %" PRI_STR " is left out, it clashes with %" PRI_STR "\n",
+              Name.Length, Name.Chars, Names[Index].Length, Names[Index].Chars);
+    }
+  }
+  if (!Known && *Count < MAX_LOCATION_NAMES)
+  {
+    GLString* Copy = Names + (*Count)++;
+    Copy->Chars = (char*)malloc(Name.Length);
+    Copy->Length = Name.Length;
+    memcpy(Copy->Chars, Name.Chars, Name.Length);
+  }
+}
+
+static inline
+int ParseFile(char* Filename, GLArbToken* ArbHash,
+               GLToken* FunctionsHash, unsigned int* FunctionCount,
+               GLToken* DefinesHash, unsigned int* DefinesCount,
+               GLLocations* Locations, GLStats* Stats, GLSettings* Settings)
+{
+  double Start = Stats ? GetWallClock() : 0;
+  unsigned long long BytesRead = Stats ? Stats->BytesRead : 0;
+  BeginPhase(Stats);
+  char* Data = ReadEntireFile(Filename, Stats);
+  EndPhase(Stats, PhaseInputRead);
+  int Success = 0;
+  if (Data)
+  {
+    BeginPhase(Stats);
+    unsigned long long TokenCount = 0;
+    GLTokenizer Tokenizer;
+    Tokenizer.At = Data;
+    while(*Tokenizer.At)
+    {
+      GLToken Token = ParseToken(&Tokenizer);
+      TokenCount++;
+      if (StartsWith(Token.Value, "gl") && IsUpperCase(Token.Value.Chars[2]))
+      {
+        if (!Contains(FunctionsHash, Token) && IsKnownOrIgnoredToken(ArbHash, &Token, Settings))
+        {
+          AddToken(FunctionsHash, Token);
+          *FunctionCount += 1;
+        }
+        if (Locations && Token.Value.Length == 20 && Equal(Token.Value, "glGetUniformLocation"))
+        {
+          GLString Name = ParseLocationName(Tokenizer.At);
+          if (Name.Length)
+          {
+            AddLocationName(Locations->Uniforms, &Locations->UniformCount, Name);
+          }
+        }
+        else if (Locations && Token.Value.Length == 19 && Equal(Token.Value, "glGetAttribLocation"))
+        {
+          GLString Name = ParseLocationName(Tokenizer.At);
+          if (Name.Length)
+          {
+            AddLocationName(Locations->Attributes, &Locations->AttributeCount, Name);
+          }
+        }
+      }
+      if (StartsWith(Token.Value, "GL_"))
+      {
+        if (!Contains(DefinesHash, Token) && IsKnownOrIgnoredToken(ArbHash, &Token, Settings))
+        {
+          AddToken(DefinesHash, Token);
+          *DefinesCount += 1;
+        }
+      }
+    }
+    if (Stats)
+    {
+      Stats->InputTokens += TokenCount;
+    }
+    EndPhase(Stats, PhaseInputScan);
+    if (Stats && Stats->Trace)
+    {
+      WriteTraceEvent(Stats, "ParseFile", Start, GetWallClock(), Filename, Stats->BytesRead - BytesRead);
+    }
+    free(Data);
+    Success = 1;
+  }
+  else
+  {
+    fprintf(stderr, "Couldn't open file %s", Filename);
+  }
+  return Success;
+}
+
+
+static
+void WriteAtomics(FILE* Output)
+{
+  const char* Generated =
+    "#ifndef GEN_ATOMICS\n"
+    "#define GEN_ATOMICS\n"
+    "#if defined(_MSC_VER)\n"
+    "#include <intrin.h>\n"
+    "#define GEN_AtomicLoadAcquire(Pointer) _InterlockedOr((volatile long*)(Pointer), 0)\n"
+    "#define GEN_AtomicStoreRelease(Pointer, Value) _InterlockedExchange((volatile long*)(Pointer), (Value))\n"
+    "#define GEN_AtomicCompareExchange(Pointer, Expected, Desired) \\\n"
+    "  (_InterlockedCompareExchange((volatile long*)(Pointer), (Desired), (Expected)) == (Expected))\n"
+    "#define GEN_AtomicCompareExchangePointer(Pointer, Expected, Desired) \\\n"
+    "  (_InterlockedCompareExchangePointer((void* volatile*)(Pointer), (Desired), (Expected)) == (Expected))\n"
+    "#define GEN_AtomicLoadAcquirePointer(Pointer) \\\n"
+    "  _InterlockedCompareExchangePointer((void* volatile*)(Pointer), 0, 0)\n"
+    "#define GEN_Yield() SwitchToThread()\n"
+    "#else\n"
+    "#include <sched.h>\n"
+    "#define GEN_AtomicLoadAcquire(Pointer) __atomic_load_n((Pointer), __ATOMIC_ACQUIRE)\n"
+    "#define GEN_AtomicStoreRelease(Pointer, Value) __atomic_store_n((Pointer), (Value), __ATOMIC_RELEASE)\n"
+    "#define GEN_AtomicCompareExchange(Pointer, Expected, Desired) \\\n"
+    "  __sync_bool_compare_and_swap((Pointer), (Expected), (Desired))\n"
+    "#define GEN_AtomicCompareExchangePointer(Pointer, Expected, Desired) \\\n"
+    "  __sync_bool_compare_and_swap((Pointer), (Expected), (Desired))\n"
+    "#define GEN_AtomicLoadAcquirePointer(Pointer) __atomic_load_n((Pointer), __ATOMIC_ACQUIRE)\n"
+    "#define GEN_Yield() sched_yield()\n"
+    "#endif\n"
+    "#endif\n\n";
+  fprintf(Output, "%s", Generated);
+}
+
+static
+void WriteThreadLocal(FILE* Output)
+{
+  const char* Generated =
+    "#ifndef GEN_THREAD_LOCAL\n"
+    "#if defined(_MSC_VER)\n"
+    "#define GEN_THREAD_LOCAL __declspec(thread)\n"
+    "#else\n"
+    "#define GEN_THREAD_LOCAL __thread\n"
+    "#endif\n"
+    "#endif\n\n";
+  fprintf(Output, "%s", Generated);
+}
+
+enum GLStateGroup
+{
+  StateProgram,
+  StateVertexArray,
+  StateActiveTexture,
+  StateTextures,
+  StateBuffers,
+  StateFramebuffers,
+  StateRenderbuffer,
+  StateSamplers,
+  StateCapabilities,
+  StateBlendFunc,
+  StateBlendEquation,
+  StateDepthFunc,
+  StateDepthMask,
+  StateCullFace,
+  StateFrontFace,
+  StateViewport,
+  StateQueries,
+  StateGroupCount,
+};
+
+struct GLStateGroupInfo
+{
+  const char* Fields;
+  const char* Helpers;
+};
+
+// Struct members and helpers of each group of shadowed state, in
+// GLStateGroup order. Bindings and enums are stored plus one so that zero
+// means unknown.
+static const GLStateGroupInfo StateGroupInfos[StateGroupCount] =
+{
+  {
+    "  GLuint Program;\n",
+    ""
+  },
+  {
+    "  GLuint VertexArray;\n",
+    ""
+  },
+  {
+    "  GLuint ActiveTexture;\n",
+    ""
+  },
+  {
+    "  GLuint Textures[GEN_MAX_TEXTURE_UNITS][11];\n",
+    "static inline int GEN_TextureTargetIndex(GLenum Target)\n"
+    "{\n"
+    "  switch (Target)\n"
+    "  {\n"
+    "    case 0x0DE0: return 0;  // GL_TEXTURE_1D\n"
+    "    case 0x0DE1: return 1;  // GL_TEXTURE_2D\n"
+    "    case 0x806F: return 2;  // GL_TEXTURE_3D\n"
+    "    case 0x8C18: return 3;  // GL_TEXTURE_1D_ARRAY\n"
+    "    case 0x8C1A: return 4;  // GL_TEXTURE_2D_ARRAY\n"
+    "    case 0x84F5: return 5;  // GL_TEXTURE_RECTANGLE\n"
+    "    case 0x8513: return 6;  // GL_TEXTURE_CUBE_MAP\n"
+    "    case 0x9009: return 7;  // GL_TEXTURE_CUBE_MAP_ARRAY\n"
+    "    case 0x8C2A: return 8;  // GL_TEXTURE_BUFFER\n"
+    "    case 0x9100: return 9;  // GL_TEXTURE_2D_MULTISAMPLE\n"
+    "    case 0x9102: return 10; // GL_TEXTURE_2D_MULTISAMPLE_ARRAY\n"
+    "  }\n"
+    "  return -1;\n"
+    "}\n"
+  },
+  {
+    "  GLuint Buffers[12];\n",
+    "// GL_ELEMENT_ARRAY_BUFFER and GL_TRANSFORM_FEEDBACK_BUFFER belong to vertex\n"
+    "// array and transform feedback objects and are never shadowed.\n"
+    "static inline int GEN_BufferTargetIndex(GLenum Target)\n"
+    "{\n"
+    "  switch (Target)\n"
+    "  {\n"
+    "    case 0x8892: return 0;  // GL_ARRAY_BUFFER\n"
+    "    case 0x8F36: return 1;  // GL_COPY_READ_BUFFER\n"
+    "    case 0x8F37: return 2;  // GL_COPY_WRITE_BUFFER\n"
+    "    case 0x88EB: return 3;  // GL_PIXEL_PACK_BUFFER\n"
+    "    case 0x88EC: return 4;  // GL_PIXEL_UNPACK_BUFFER\n"
+    "    case 0x8A11: return 5;  // GL_UNIFORM_BUFFER\n"
+    "    case 0x8C2A: return 6;  // GL_TEXTURE_BUFFER\n"
+    "    case 0x8F3F: return 7;  // GL_DRAW_INDIRECT_BUFFER\n"
+    "    case 0x90EE: return 8;  // GL_DISPATCH_INDIRECT_BUFFER\n"
+    "    case 0x90D2: return 9;  // GL_SHADER_STORAGE_BUFFER\n"
+    "    case 0x92C0: return 10; // GL_ATOMIC_COUNTER_BUFFER\n"
+    "    case 0x9192: return 11; // GL_QUERY_BUFFER\n"
+    "  }\n"
+    "  return -1;\n"
+    "}\n"
+  },
+  {
+    "  GLuint Framebuffers[2];\n",
+    ""
+  },
+  {
+    "  GLuint Renderbuffer;\n",
+    ""
+  },
+  {
+    "  GLuint Samplers[GEN_MAX_TEXTURE_UNITS];\n",
+    ""
+  },
+  {
+    "  unsigned int CapabilitiesKnown;\n"
+    "  unsigned int CapabilitiesEnabled;\n",
+    "static inline int GEN_CapabilityIndex(GLenum Capability)\n"
+    "{\n"
+    "  switch (Capability)\n"
+    "  {\n"
+    "    case 0x0BE2: return 0;  // GL_BLEND\n"
+    "    case 0x0B44: return 1;  // GL_CULL_FACE\n"
+    "    case 0x0B71: return 2;  // GL_DEPTH_TEST\n"
+    "    case 0x0B90: return 3;  // GL_STENCIL_TEST\n"
+    "    case 0x0C11: return 4;  // GL_SCISSOR_TEST\n"
+    "    case 0x8037: return 5;  // GL_POLYGON_OFFSET_FILL\n"
+    "    case 0x809D: return 6;  // GL_MULTISAMPLE\n"
+    "    case 0x809E: return 7;  // GL_SAMPLE_ALPHA_TO_COVERAGE\n"
+    "    case 0x8DB9: return 8;  // GL_FRAMEBUFFER_SRGB\n"
+    "    case 0x8F9D: return 9;  // GL_PRIMITIVE_RESTART\n"
+    "    case 0x0BD0: return 10; // GL_DITHER\n"
+    "    case 0x8C89: return 11; // GL_RASTERIZER_DISCARD\n"
+    "    case 0x864F: return 12; // GL_DEPTH_CLAMP\n"
+    "    case 0x884F: return 13; // GL_TEXTURE_CUBE_MAP_SEAMLESS\n"
+    "    case 0x8642: return 14; // GL_PROGRAM_POINT_SIZE\n"
+    "    case 0x0B20: return 15; // GL_LINE_SMOOTH\n"
+    "    case 0x8D69: return 16; // GL_PRIMITIVE_RESTART_FIXED_INDEX\n"
+    "    case 0x80A0: return 17; // GL_SAMPLE_COVERAGE\n"
+    "    case 0x8E51: return 18; // GL_SAMPLE_MASK\n"
+    "    case 0x92E0: return 19; // GL_DEBUG_OUTPUT\n"
+    "    case 0x8242: return 20; // GL_DEBUG_OUTPUT_SYNCHRONOUS\n"
+    "  }\n"
+    "  return -1;\n"
+    "}\n"
+  },
+  {
+    "  GLuint BlendFunc[4];\n",
+    ""
+  },
+  {
+    "  GLuint BlendEquation;\n",
+    ""
+  },
+  {
+    "  GLuint DepthFunc;\n",
+    ""
+  },
+  {
+    "  GLuint DepthMask;\n",
+    ""
+  },
+  {
+    "  GLuint CullFace;\n",
+    ""
+  },
+  {
+    "  GLuint FrontFace;\n",
+    ""
+  },
+  {
+    "  GLint Viewport[4];\n"
+    "  int ViewportKnown;\n",
+    ""
+  },
+  {
+    "",
+    ""
+  },
+};
+
+struct GLStateFunction
+{
+  const char* Name;
+  int Group;
+  int Primary;
+  const char* Code;
+};
+
+// Wrapper code of the functions that read or update the shadow state. $N is
+// replaced with the name of the Nth argument. A group is shadowed when one
+// of its primary functions is used, the other functions only keep it
+// correct.
+static const GLStateFunction StateFunctions[] =
+{
+  {
+    "glUseProgram", StateProgram, 1,
+    "if (GEN_State->Program == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->Program = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glBindVertexArray", StateVertexArray, 1,
+    "if (GEN_State->VertexArray == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->VertexArray = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glDeleteVertexArrays", StateVertexArray, 0,
+    "GEN_ForgetNames(&GEN_State->VertexArray, 1, $0, $1);\n"
+  },
+  {
+    "glActiveTexture", StateActiveTexture, 1,
+    "if (GEN_State->ActiveTexture == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->ActiveTexture = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glBindTexture", StateTextures, 1,
+    "GLuint GEN_Unit = GEN_TEXTURE_UNIT(GEN_State);\n"
+    "int GEN_Target = GEN_TextureTargetIndex($0);\n"
+    "if (GEN_Unit < GEN_MAX_TEXTURE_UNITS && GEN_Target >= 0)\n"
+    "{\n"
+    "  if (GEN_State->Textures[GEN_Unit][GEN_Target] == $1 + 1)\n"
+    "  {\n"
+    "    return;\n"
+    "  }\n"
+    "  GEN_State->Textures[GEN_Unit][GEN_Target] = $1 + 1;\n"
+    "}\n"
+  },
+  {
+    "glBindTextureUnit", StateTextures, 0,
+    "if ($0 < GEN_MAX_TEXTURE_UNITS)\n"
+    "{\n"
+    "  memset(GEN_State->Textures[$0], 0, sizeof(GEN_State->Textures[$0]));\n"
+    "}\n"
+  },
+  {
+    "glBindTextures", StateTextures, 0,
+    "memset(GEN_State->Textures, 0, sizeof(GEN_State->Textures));\n"
+  },
+  {
+    "glDeleteTextures", StateTextures, 0,
+    "GEN_ForgetNames(&GEN_State->Textures[0][0], GEN_MAX_TEXTURE_UNITS*11, $0, $1);\n"
+  },
+  {
+    "glBindBuffer", StateBuffers, 1,
+    "int GEN_Target = GEN_BufferTargetIndex($0);\n"
+    "if (GEN_Target >= 0)\n"
+    "{\n"
+    "  if (GEN_State->Buffers[GEN_Target] == $1 + 1)\n"
+    "  {\n"
+    "    return;\n"
+    "  }\n"
+    "  GEN_State->Buffers[GEN_Target] = $1 + 1;\n"
+    "}\n"
+  },
+  {
+    "glBindBufferBase", StateBuffers, 0,
+    "int GEN_Target = GEN_BufferTargetIndex($0);\n"
+    "if (GEN_Target >= 0)\n"
+    "{\n"
+    "  GEN_State->Buffers[GEN_Target] = $2 + 1;\n"
+    "}\n"
+  },
+  {
+    "glBindBufferRange", StateBuffers, 0,
+    "int GEN_Target = GEN_BufferTargetIndex($0);\n"
+    "if (GEN_Target >= 0)\n"
+    "{\n"
+    "  GEN_State->Buffers[GEN_Target] = $2 + 1;\n"
+    "}\n"
+  },
+  {
+    "glDeleteBuffers", StateBuffers, 0,
+    "GEN_ForgetNames(GEN_State->Buffers, 12, $0, $1);\n"
+  },
+  {
+    "glBindFramebuffer", StateFramebuffers, 1,
+    "int GEN_Draw = $0 == 0x8D40 || $0 == 0x8CA9; // GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER\n"
+    "int GEN_Read = $0 == 0x8D40 || $0 == 0x8CA8; // GL_FRAMEBUFFER, GL_READ_FRAMEBUFFER\n"
+    "if ((GEN_Draw || GEN_Read) &&\n"
+    "    (!GEN_Draw || GEN_State->Framebuffers[0] == $1 + 1) &&\n"
+    "    (!GEN_Read || GEN_State->Framebuffers[1] == $1 + 1))\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "if (GEN_Draw)\n"
+    "{\n"
+    "  GEN_State->Framebuffers[0] = $1 + 1;\n"
+    "}\n"
+    "if (GEN_Read)\n"
+    "{\n"
+    "  GEN_State->Framebuffers[1] = $1 + 1;\n"
+    "}\n"
+  },
+  {
+    "glDeleteFramebuffers", StateFramebuffers, 0,
+    "GEN_ForgetNames(GEN_State->Framebuffers, 2, $0, $1);\n"
+  },
+  {
+    "glBindRenderbuffer", StateRenderbuffer, 1,
+    "if (GEN_State->Renderbuffer == (GLuint)$1 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->Renderbuffer = (GLuint)$1 + 1;\n"
+  },
+  {
+    "glDeleteRenderbuffers", StateRenderbuffer, 0,
+    "GEN_ForgetNames(&GEN_State->Renderbuffer, 1, $0, $1);\n"
+  },
+  {
+    "glBindSampler", StateSamplers, 1,
+    "if ($0 < GEN_MAX_TEXTURE_UNITS)\n"
+    "{\n"
+    "  if (GEN_State->Samplers[$0] == $1 + 1)\n"
+    "  {\n"
+    "    return;\n"
+    "  }\n"
+    "  GEN_State->Samplers[$0] = $1 + 1;\n"
+    "}\n"
+  },
+  {
+    "glBindSamplers", StateSamplers, 0,
+    "memset(GEN_State->Samplers, 0, sizeof(GEN_State->Samplers));\n"
+  },
+  {
+    "glDeleteSamplers", StateSamplers, 0,
+    "GEN_ForgetNames(GEN_State->Samplers, GEN_MAX_TEXTURE_UNITS, $0, $1);\n"
+  },
+  {
+    "glEnable", StateCapabilities, 1,
+    "int GEN_Bit = GEN_CapabilityIndex($0);\n"
+    "if (GEN_Bit >= 0)\n"
+    "{\n"
+    "  unsigned int GEN_Mask = 1u << GEN_Bit;\n"
+    "  if (GEN_State->CapabilitiesKnown & GEN_State->CapabilitiesEnabled & GEN_Mask)\n"
+    "  {\n"
+    "    return;\n"
+    "  }\n"
+    "  GEN_State->CapabilitiesKnown |= GEN_Mask;\n"
+    "  GEN_State->CapabilitiesEnabled |= GEN_Mask;\n"
+    "}\n"
+  },
+  {
+    "glDisable", StateCapabilities, 1,
+    "int GEN_Bit = GEN_CapabilityIndex($0);\n"
+    "if (GEN_Bit >= 0)\n"
+    "{\n"
+    "  unsigned int GEN_Mask = 1u << GEN_Bit;\n"
+    "  if (GEN_State->CapabilitiesKnown & ~GEN_State->CapabilitiesEnabled & GEN_Mask)\n"
+    "  {\n"
+    "    return;\n"
+    "  }\n"
+    "  GEN_State->CapabilitiesKnown |= GEN_Mask;\n"
+    "  GEN_State->CapabilitiesEnabled &= ~GEN_Mask;\n"
+    "}\n"
+  },
+  {
+    "glBlendFunc", StateBlendFunc, 1,
+    "if (GEN_State->BlendFunc[0] == $0 + 1 && GEN_State->BlendFunc[1] == $1 + 1 &&\n"
+    "    GEN_State->BlendFunc[2] == $0 + 1 && GEN_State->BlendFunc[3] == $1 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->BlendFunc[0] = GEN_State->BlendFunc[2] = $0 + 1;\n"
+    "GEN_State->BlendFunc[1] = GEN_State->BlendFunc[3] = $1 + 1;\n"
+  },
+  {
+    "glBlendFuncSeparate", StateBlendFunc, 1,
+    "if (GEN_State->BlendFunc[0] == $0 + 1 && GEN_State->BlendFunc[1] == $1 + 1 &&\n"
+    "    GEN_State->BlendFunc[2] == $2 + 1 && GEN_State->BlendFunc[3] == $3 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->BlendFunc[0] = $0 + 1;\n"
+    "GEN_State->BlendFunc[1] = $1 + 1;\n"
+    "GEN_State->BlendFunc[2] = $2 + 1;\n"
+    "GEN_State->BlendFunc[3] = $3 + 1;\n"
+  },
+  {
+    "glBlendEquation", StateBlendEquation, 1,
+    "if (GEN_State->BlendEquation == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->BlendEquation = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glBlendEquationSeparate", StateBlendEquation, 0,
+    "GEN_State->BlendEquation = $0 == $1 ? $0 + 1 : 0;\n"
+  },
+  {
+    "glDepthFunc", StateDepthFunc, 1,
+    "if (GEN_State->DepthFunc == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->DepthFunc = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glDepthMask", StateDepthMask, 1,
+    "if (GEN_State->DepthMask == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->DepthMask = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glCullFace", StateCullFace, 1,
+    "if (GEN_State->CullFace == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->CullFace = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glFrontFace", StateFrontFace, 1,
+    "if (GEN_State->FrontFace == (GLuint)$0 + 1)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->FrontFace = (GLuint)$0 + 1;\n"
+  },
+  {
+    "glViewport", StateViewport, 1,
+    "if (GEN_State->ViewportKnown && GEN_State->Viewport[0] == $0 && GEN_State->Viewport[1] == $1 &&\n"
+    "    GEN_State->Viewport[2] == $2 && GEN_State->Viewport[3] == $3)\n"
+    "{\n"
+    "  return;\n"
+    "}\n"
+    "GEN_State->Viewport[0] = $0;\n"
+    "GEN_State->Viewport[1] = $1;\n"
+    "GEN_State->Viewport[2] = $2;\n"
+    "GEN_State->Viewport[3] = $3;\n"
+    "GEN_State->ViewportKnown = 1;\n"
+  },
+  {
+    "glGetIntegerv", StateQueries, 0,
+    "GLint GEN_Values[4];\n"
+    "int GEN_Count = GEN_QueryState(GEN_State, $0, GEN_Values);\n"
+    "if (GEN_Count)\n"
+    "{\n"
+    "  memcpy($1, GEN_Values, sizeof(GLint)*(size_t)GEN_Count);\n"
+    "  return;\n"
+    "}\n"
+  },
+  {
+    "glGetBooleanv", StateQueries, 0,
+    "GLint GEN_Values[4];\n"
+    "int GEN_Count = GEN_QueryState(GEN_State, $0, GEN_Values);\n"
+    "if (GEN_Count)\n"
+    "{\n"
+    "  for (int GEN_Index = 0; GEN_Index < GEN_Count; ++GEN_Index)\n"
+    "  {\n"
+    "    $1[GEN_Index] = (GLboolean)(GEN_Values[GEN_Index] != 0);\n"
+    "  }\n"
+    "  return;\n"
+    "}\n"
+  },
+  {
+    "glGetFloatv", StateQueries, 0,
+    "GLint GEN_Values[4];\n"
+    "int GEN_Count = GEN_QueryState(GEN_State, $0, GEN_Values);\n"
+    "if (GEN_Count)\n"
+    "{\n"
+    "  for (int GEN_Index = 0; GEN_Index < GEN_Count; ++GEN_Index)\n"
+    "  {\n"
+    "    $1[GEN_Index] = (GLfloat)GEN_Values[GEN_Index];\n"
+    "  }\n"
+    "  return;\n"
+    "}\n"
+  },
+  {
+    "glIsEnabled", StateCapabilities, 0,
+    "GLint GEN_Value;\n"
+    "if (GEN_CapabilityIndex($0) >= 0 && GEN_QueryState(GEN_State, $0, &GEN_Value))\n"
+    "{\n"
+    "  return (GLboolean)GEN_Value;\n"
+    "}\n"
+  },
+};
+
+struct GLStateQuery
+{
+  const char* Name;
+  const char* Alias;
+  const char* Value;
+  int Group;
+  const char* Code;
+};
+
+// glGet* parameters answered from the shadow state, and the code that fills
+// Values and sets Result to the number of values when the state is known.
+// Alias is another name of the same value in the registry, like
+// GL_BLEND_EQUATION for GL_BLEND_EQUATION_RGB, and is matched as well.
+static const GLStateQuery StateQueryInfos[] =
+{
+  {
+    "GL_CURRENT_PROGRAM", 0, "0x8B8D", StateProgram,
+    "if (State->Program)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Program - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_VERTEX_ARRAY_BINDING", 0, "0x85B5", StateVertexArray,
+    "if (State->VertexArray)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->VertexArray - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_ACTIVE_TEXTURE", 0, "0x84E0", StateActiveTexture,
+    "if (State->ActiveTexture)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->ActiveTexture - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_1D", 0, "0x8068", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][0])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][0] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_2D", 0, "0x8069", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][1])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][1] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_3D", 0, "0x806A", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][2])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][2] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_1D_ARRAY", 0, "0x8C1C", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][3])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][3] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_2D_ARRAY", 0, "0x8C1D", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][4])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][4] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_RECTANGLE", 0, "0x84F6", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][5])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][5] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_CUBE_MAP", 0, "0x8514", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][6])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][6] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_CUBE_MAP_ARRAY", 0, "0x900A", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][7])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][7] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_2D_MULTISAMPLE", 0, "0x9104", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][9])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][9] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY", 0, "0x9105", StateTextures,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Textures[Unit][10])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Textures[Unit][10] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_ARRAY_BUFFER_BINDING", 0, "0x8894", StateBuffers,
+    "if (State->Buffers[0])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[0] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_COPY_READ_BUFFER_BINDING", 0, "0x8F36", StateBuffers,
+    "if (State->Buffers[1])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[1] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_COPY_WRITE_BUFFER_BINDING", 0, "0x8F37", StateBuffers,
+    "if (State->Buffers[2])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[2] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_PIXEL_PACK_BUFFER_BINDING", 0, "0x88ED", StateBuffers,
+    "if (State->Buffers[3])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[3] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_PIXEL_UNPACK_BUFFER_BINDING", 0, "0x88EF", StateBuffers,
+    "if (State->Buffers[4])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[4] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_UNIFORM_BUFFER_BINDING", 0, "0x8A28", StateBuffers,
+    "if (State->Buffers[5])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[5] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_DRAW_INDIRECT_BUFFER_BINDING", 0, "0x8F43", StateBuffers,
+    "if (State->Buffers[7])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[7] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_DISPATCH_INDIRECT_BUFFER_BINDING", 0, "0x90EF", StateBuffers,
+    "if (State->Buffers[8])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[8] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_SHADER_STORAGE_BUFFER_BINDING", 0, "0x90D3", StateBuffers,
+    "if (State->Buffers[9])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[9] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_ATOMIC_COUNTER_BUFFER_BINDING", 0, "0x92C1", StateBuffers,
+    "if (State->Buffers[10])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[10] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_QUERY_BUFFER_BINDING", 0, "0x9193", StateBuffers,
+    "if (State->Buffers[11])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Buffers[11] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_DRAW_FRAMEBUFFER_BINDING", "GL_FRAMEBUFFER_BINDING", "0x8CA6", StateFramebuffers,
+    "if (State->Framebuffers[0])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Framebuffers[0] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_READ_FRAMEBUFFER_BINDING", 0, "0x8CAA", StateFramebuffers,
+    "if (State->Framebuffers[1])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Framebuffers[1] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_RENDERBUFFER_BINDING", 0, "0x8CA7", StateRenderbuffer,
+    "if (State->Renderbuffer)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Renderbuffer - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_SAMPLER_BINDING", 0, "0x8919", StateSamplers,
+    "GLuint Unit = GEN_TEXTURE_UNIT(State);\n"
+    "if (Unit < GEN_MAX_TEXTURE_UNITS && State->Samplers[Unit])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->Samplers[Unit] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_SRC_RGB", 0, "0x80C9", StateBlendFunc,
+    "if (State->BlendFunc[0])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendFunc[0] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_DST_RGB", 0, "0x80C8", StateBlendFunc,
+    "if (State->BlendFunc[1])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendFunc[1] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_SRC_ALPHA", 0, "0x80CB", StateBlendFunc,
+    "if (State->BlendFunc[2])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendFunc[2] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_DST_ALPHA", 0, "0x80CA", StateBlendFunc,
+    "if (State->BlendFunc[3])\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendFunc[3] - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_EQUATION_RGB", "GL_BLEND_EQUATION", "0x8009", StateBlendEquation,
+    "if (State->BlendEquation)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendEquation - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_BLEND_EQUATION_ALPHA", 0, "0x883D", StateBlendEquation,
+    "if (State->BlendEquation)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->BlendEquation - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_DEPTH_FUNC", 0, "0x0B74", StateDepthFunc,
+    "if (State->DepthFunc)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->DepthFunc - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_DEPTH_WRITEMASK", 0, "0x0B72", StateDepthMask,
+    "if (State->DepthMask)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->DepthMask - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_CULL_FACE_MODE", 0, "0x0B45", StateCullFace,
+    "if (State->CullFace)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->CullFace - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_FRONT_FACE", 0, "0x0B46", StateFrontFace,
+    "if (State->FrontFace)\n"
+    "{\n"
+    "  Values[0] = (GLint)(State->FrontFace - 1);\n"
+    "  Result = 1;\n"
+    "}\n"
+  },
+  {
+    "GL_VIEWPORT", 0, "0x0BA2", StateViewport,
+    "if (State->ViewportKnown)\n"
+    "{\n"
+    "  memcpy(Values, State->Viewport, sizeof(State->Viewport));\n"
+    "  Result = 4;\n"
+    "}\n"
+  },
+};
+
+
+// Returns the bit mask of the shadowed state groups, given the functions
+// found in the inputs.
+static
+unsigned int GetStateGroups(GLArbToken** Functions, unsigned int FunctionCount)
+{
+  unsigned int Result = 0;
+  for (unsigned int Index = 0; Index < ArraySize(StateFunctions); ++Index)
+  {
+    const GLStateFunction* Function = StateFunctions + Index;
+    for (unsigned int FunctionIndex = 0; FunctionIndex < FunctionCount && Function->Primary; ++FunctionIndex)
+    {
+      GLString Name = Functions[FunctionIndex]->FunctionName;
+      if (IsType(Name, Function->Name))
+      {
+        Result |= 1u << Function->Group;
+        break;
+      }
+    }
+  }
+  return Result;
+}
+
+// Returns non zero if the inputs use the glGet* parameter under either name.
+static
+int IsStateQueryUsed(const GLStateQuery* Query, GLToken* Defines, unsigned int DefineCount)
+{
+  int Result = 0;
+  const char* Names[2] = {Query->Name, Query->Alias};
+  for (int NameIndex = 0; NameIndex < 2 && Names[NameIndex]; ++NameIndex)
+  {
+    GLString Name;
+    Name.Chars = (char*)Names[NameIndex];
+    Name.Length = (unsigned int)strlen(Name.Chars);
+    unsigned int Hash = GetStringHash(Name);
+    for (unsigned int DefineIndex = 0; DefineIndex < DefineCount; ++DefineIndex)
+    {
+      Result |= Defines[DefineIndex].Hash == Hash;
+    }
+  }
+  return Result;
+}
+
+// Returns the bit of StateQueries if any glGet* parameter found in the inputs
+// or any capability can be answered from the shadowed state groups.
+static
+unsigned int GetStateQueries(GLToken* Defines, unsigned int DefineCount, unsigned int StateGroups)
+{
+  unsigned int Result = (StateGroups & (1u << StateCapabilities)) ? (1u << StateQueries) : 0;
+  for (unsigned int Index = 0; Index < ArraySize(StateQueryInfos); ++Index)
+  {
+    if ((StateGroups & (1u << StateQueryInfos[Index].Group)) &&
+        IsStateQueryUsed(StateQueryInfos + Index, Defines, DefineCount))
+    {
+      Result = 1u << StateQueries;
+    }
+  }
+  return Result;
+}
+
+// Writes the shadow state intercept of a wrapper, if the function has one.
+static
+void WriteStateCacheCode(FILE* Output, const char* Prefix, GLArbToken* ArbToken, unsigned int StateGroups)
+{
+  for (unsigned int Index = 0; Index < ArraySize(StateFunctions); ++Index)
+  {
+    const GLStateFunction* Function = StateFunctions + Index;
+    if ((StateGroups & (1u << Function->Group)) && IsType(ArbToken->FunctionName, Function->Name))
+    {
+      GLParameter Parameters[MAX_PARAMETERS];
+      int Count = GetParameters(ArbToken->Parameters, Parameters);
+      fprintf(Output, "  %sOpenGLContextState* GEN_State = GEN_ContextState;\n  ", Prefix);
+      for (const char* At = Function->Code; *At; ++At)
+      {
+        if (*At == '$' && At[1] >= '0' && At[1] <= '9' && At[1] - '0' < Count)
+        {
+          GLString Name = Parameters[At[1] - '0'].Name;
+          fprintf(Output, "%" PRI_STR, Name.Length, Name.Chars);
+          At++;
+        }
+        else
+        {
+          fputc(*At, Output);
+          if (*At == '\n' && At[1])
+          {
+            fprintf(Output, "  ");
+          }
+        }
+      }
+      break;
+    }
+  }
+}
+
+// Writes the per-context shadow state used by -statecache wrappers.
+static
+void WriteStateCache(FILE* Output, const char* Prefix, unsigned int StateGroups,
+                     GLToken* Defines, unsigned int DefineCount)
+{
+  WriteThreadLocal(Output);
+  const char* Generated =
+    "#include <string.h>\n"
+    "#ifndef GEN_MAX_TEXTURE_UNITS\n"
+    "#define GEN_MAX_TEXTURE_UNITS 32\n"
+    "#endif\n\n"
+    "// Shadow copy of the OpenGL state set through the wrappers, used to skip\n"
+    "// calls that wouldn't change anything. Keep one per context.\n"
+    "typedef struct %sOpenGLContextState\n"
+    "{\n";
+  fprintf(Output, Generated, Prefix);
+  for (int Group = 0; Group < StateGroupCount; ++Group)
+  {
+    if (StateGroups & (1u << Group))
+    {
+      fprintf(Output, "%s", StateGroupInfos[Group].Fields);
+    }
+  }
+  if (!StateGroups)
+  {
+    fprintf(Output, "  int Unused;\n");
+  }
+  Generated =
+    "} %sOpenGLContextState;\n\n"
+    "static %sOpenGLContextState GEN_DefaultContextState;\n"
+    "static GEN_THREAD_LOCAL %sOpenGLContextState* GEN_ContextState = &GEN_DefaultContextState;\n\n"
+    "// Selects the shadow state of the context current on the calling thread.\n"
+    "// Passing null selects the default state.\n"
+    "static inline void %sOpenGLMakeContextStateCurrent(%sOpenGLContextState* State)\n"
+    "{\n"
+    "  GEN_ContextState = State ? State : &GEN_DefaultContextState;\n"
+    "}\n\n"
+    "// Forgets the shadow state of the current context. Call it after code that\n"
+    "// doesn't go through the wrappers changed OpenGL state.\n"
+    "static inline void %sOpenGLInvalidateStateCache()\n"
+    "{\n"
+    "  memset(GEN_ContextState, 0, sizeof(*GEN_ContextState));\n"
+    "}\n\n"
+    "static inline void GEN_ForgetNames(GLuint* Values, int ValueCount, GLsizei Count, const GLuint* Names)\n"
+    "{\n"
+    "  for (GLsizei Index = 0; Index < Count; ++Index)\n"
+    "  {\n"
+    "    for (int ValueIndex = 0; ValueIndex < ValueCount && Names[Index]; ++ValueIndex)\n"
+    "    {\n"
+    "      if (Values[ValueIndex] == Names[Index] + 1)\n"
+    "      {\n"
+    "        Values[ValueIndex] = 1;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+  if (StateGroups & ((1u << StateTextures) | (1u << StateSamplers)))
+  {
+    if (StateGroups & (1u << StateActiveTexture))
+    {
+      fprintf(Output, "#define GEN_TEXTURE_UNIT(State) ((State)->ActiveTexture - 1 - 0x84C0) // GL_TEXTURE0\n");
+    }
+    else
+    {
+      fprintf(Output, "#define GEN_TEXTURE_UNIT(State) 0u\n");
+    }
+  }
+  for (int Group = 0; Group < StateGroupCount; ++Group)
+  {
+    if (StateGroups & (1u << Group))
+    {
+      fprintf(Output, "%s", StateGroupInfos[Group].Helpers);
+    }
+  }
+  if (StateGroups & (1u << StateQueries))
+  {
+    Generated =
+      "\n"
+      "// Answers a glGet* query from the shadow state. Returns the number of values\n"
+      "// written or zero if the query has to go to the driver.\n"
+      "static inline int GEN_QueryState(%sOpenGLContextState* State, GLenum Name, GLint* Values)\n"
+      "{\n"
+      "  int Result = 0;\n"
+      "  switch (Name)\n"
+      "  {\n";
+    fprintf(Output, Generated, Prefix);
+    for (unsigned int Index = 0; Index < ArraySize(StateQueryInfos); ++Index)
+    {
+      const GLStateQuery* Query = StateQueryInfos + Index;
+      if ((StateGroups & (1u << Query->Group)) && IsStateQueryUsed(Query, Defines, DefineCount))
+      {
+        fprintf(Output, "    case %s: // %s\n    {\n      ", Query->Value, Query->Name);
+        for (const char* At = Query->Code; *At; ++At)
+        {
+          fputc(*At, Output);
+          if (*At == '\n' && At[1])
+          {
+            fprintf(Output, "      ");
+          }
+        }
+        fprintf(Output, "    } break;\n");
+      }
+    }
+    if (StateGroups & (1u << StateCapabilities))
+    {
+      Generated =
+        "    default:\n"
+        "    {\n"
+        "      int Bit = GEN_CapabilityIndex(Name);\n"
+        "      if (Bit >= 0 && (State->CapabilitiesKnown & (1u << Bit)))\n"
+        "      {\n"
+        "        Values[0] = (State->CapabilitiesEnabled >> Bit) & 1;\n"
+        "        Result = 1;\n"
+        "      }\n"
+        "    } break;\n";
+      fprintf(Output, "%s", Generated);
+    }
+    fprintf(Output, "  }\n  return Result;\n}\n");
+  }
+  fprintf(Output, "\n");
+}
+
+// Writes a static inline function with the registry signature that calls
+// through the pointer table.
+static
+void WriteWrapper(FILE* Output, GLSettings* Settings, GLArbToken* ArbToken, unsigned int StateGroups)
+{
+  GLString ReturnType = TrimString(ArbToken->ReturnType);
+  GLString Parameters = GetParameterList(ArbToken->Parameters);
+  GLString Name = ArbToken->FunctionName;
+  char Arguments[1024];
+  GetArgumentNames(ArbToken->Parameters, Arguments);
+  int Void = ReturnsVoid(ArbToken);
+  fprintf(Output,
+          "static inline GEN_WRAPPER_ATTRIBUTES %" PRI_STR " APIENTRY %" PRI_STR "%" PRI_STR "\n"
+          "{\n",
+          ReturnType.Length, ReturnType.Chars,
+          Name.Length, Name.Chars,
+          Parameters.Length, Parameters.Chars);
+  if (Settings->Commands && IsDeferrable(ArbToken))
+  {
+    fprintf(Output, "  if (GEN_CommandEncoder)\n  {\n"
+                    "    GEN_Encode_%" PRI_STR "(GEN_CommandEncoder%s%s);\n    return;\n  }\n",
+            Name.Length, Name.Chars, *Arguments ? ", " : "", Arguments);
+  }
+  GLDeleteKind DeleteKind = Settings->DeferDelete ? GetDeleteKind(ArbToken) : DeleteNone;
+  if (Settings->StateCache && !DeleteKind)
+  {
+    WriteStateCacheCode(Output, Settings->Prefix ? Settings->Prefix : "", ArbToken, StateGroups);
+  }
+  if (Settings->Capture)
+  {
+    fprintf(Output, "  if (GEN_AtomicLoadAcquire(&GEN_Capturing))\n  {\n"
+                    "    GEN_Encode_%" PRI_STR "(&GEN_CaptureEncoder%s%s);\n"
+                    "    GEN_CaptureCommit();\n  }\n",
+            Name.Length, Name.Chars, *Arguments ? ", " : "", Arguments);
+  }
+  if (ArbToken->PoolDelete)
+  {
+    GLParameter Names[MAX_PARAMETERS];
+    GetParameters(ArbToken->Parameters, Names);
+    fprintf(Output, "  if (GEN_TakeNames(GEN_POOL_%" PRI_STR ", %" PRI_STR ", %" PRI_STR "))\n  {\n    return;\n  }\n",
+            Name.Length, Name.Chars, Names[0].Name.Length, Names[0].Name.Chars,
+            Names[1].Name.Length, Names[1].Name.Chars);
+  }
+  if (DeleteKind)
+  {
+    GLParameter Names[MAX_PARAMETERS];
+    GetParameters(ArbToken->Parameters, Names);
+    if (DeleteKind == DeleteNames)
+    {
+      fprintf(Output, "  GEN_QueueDeletes(GEN_ID_%" PRI_STR ", %" PRI_STR ", %" PRI_STR ");\n  return;\n",
+              Name.Length, Name.Chars, Names[0].Name.Length, Names[0].Name.Chars,
+              Names[1].Name.Length, Names[1].Name.Chars);
+    }
+    else
+    {
+      fprintf(Output, "  GEN_QueueDeletes(GEN_ID_%" PRI_STR " | GEN_DELETE_SINGLE, 1, &%" PRI_STR ");\n  return;\n",
+              Name.Length, Name.Chars, Names[0].Name.Length, Names[0].Name.Chars);
+    }
+  }
+  if (Settings->Instrument)
+  {
+    fprintf(Output, "  GEN_INSTRUMENT_BEGIN();\n");
+    if (Void)
+    {
+      fprintf(Output, "  GEN_%" PRI_STR "(%s);\n", Name.Length, Name.Chars, Arguments);
+    }
+    else
+    {
+      fprintf(Output, "  %" PRI_STR " GEN_Result = GEN_%" PRI_STR "(%s);\n",
+              ReturnType.Length, ReturnType.Chars, Name.Length, Name.Chars, Arguments);
+    }
+    fprintf(Output, "  GEN_INSTRUMENT_END(GEN_ID_%" PRI_STR ");\n", Name.Length, Name.Chars);
+    if (!Void)
+    {
+      fprintf(Output, "  return GEN_Result;\n");
+    }
+  }
+  else
+  {
+    fprintf(Output, "  %sGEN_%" PRI_STR "(%s);\n",
+            Void ? "" : "return ", Name.Length, Name.Chars, Arguments);
+  }
+  fprintf(Output, "}\n");
+}
+
+// Writes a pool of names for every used glGen* or glCreate* function that
+// has a matching glDelete* function. The wrappers take names from the pool,
+// which is refilled with one call when it runs out. Names belong to a
+// context, so each context selects its own pools like its state cache.
+static
+void WriteNamePools(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                    unsigned int FunctionCount)
+{
+  unsigned int PoolCount = 0;
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    PoolCount += Functions[Index]->PoolDelete != 0;
+  }
+  if (!PoolCount)
+  {
+    return;
+  }
+  WriteThreadLocal(Output);
+  fprintf(Output, "enum\n{\n");
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    if (ArbToken->PoolDelete)
+    {
+      fprintf(Output, "  GEN_POOL_%" PRI_STR ",\n",
+              ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
+    }
+  }
+  const char* Generated =
+    "  GEN_POOL_COUNT\n"
+    "};\n"
+    "\n"
+    "#ifndef GEN_NAME_POOL_SIZE\n"
+    "#define GEN_NAME_POOL_SIZE 64\n"
+    "#endif\n"
+    "\n"
+    "typedef void (APIENTRY *GEN_NamesProc)(GLsizei n, GLuint *names);\n"
+    "\n"
+    "typedef struct GEN_NamePool\n"
+    "{\n"
+    "  GLsizei Count;\n"
+    "  GLuint Names[GEN_NAME_POOL_SIZE];\n"
+    "} GEN_NamePool;\n"
+    "\n"
+    "// Names generated ahead of time for one context. Keep one per context.\n"
+    "typedef struct %sOpenGLNamePools\n"
+    "{\n"
+    "  GEN_NamePool Pools[GEN_POOL_COUNT];\n"
+    "} %sOpenGLNamePools;\n"
+    "\n"
+    "static %sOpenGLNamePools GEN_DefaultNamePools;\n"
+    "static GEN_THREAD_LOCAL %sOpenGLNamePools* GEN_NamePools = &GEN_DefaultNamePools;\n"
+    "\n"
+    "// Selects the name pools of the context current on the calling thread.\n"
+    "// Passing null selects the default pools.\n"
+    "static inline void %sOpenGLMakeNamePoolsCurrent(%sOpenGLNamePools* Pools)\n"
+    "{\n"
+    "  GEN_NamePools = Pools ? Pools : &GEN_DefaultNamePools;\n"
+    "}\n"
+    "\n"
+    "// Drops the names in Pools without deleting them, for contexts that are gone.\n"
+    "static inline void GEN_ForgetNamePools(%sOpenGLNamePools* Pools)\n"
+    "{\n"
+    "  for (int Pool = 0; Pool < GEN_POOL_COUNT; ++Pool)\n"
+    "  {\n"
+    "    Pools->Pools[Pool].Count = 0;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Function that generates and function that deletes the names of each pool.\n"
+    "static const unsigned short GEN_NamePoolProcs[GEN_POOL_COUNT][2] =\n"
+    "{\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    if (ArbToken->PoolDelete)
+    {
+      fprintf(Output, "  {GEN_ID_%" PRI_STR ", GEN_ID_%" PRI_STR "},\n",
+              ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+              ArbToken->PoolDelete->FunctionName.Length, ArbToken->PoolDelete->FunctionName.Chars);
+    }
+  }
+  Generated =
+    "};\n"
+    "\n"
+    "// Hands out Count names from Pool, refilling it first if needed. Returns\n"
+    "// zero for requests larger than a pool, which go to the driver.\n"
+    "static inline int GEN_TakeNames(int Pool, GLsizei Count, GLuint* Names)\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "  GEN_NamePool* NamePool = GEN_NamePools->Pools + Pool;\n"
+    "  if (Count <= GEN_NAME_POOL_SIZE)\n"
+    "  {\n"
+    "    if (NamePool->Count < Count)\n"
+    "    {\n"
+    "      GEN_NamesProc Generate = (GEN_NamesProc)GEN_PROCS[GEN_NamePoolProcs[Pool][0]];\n"
+    "      Generate(GEN_NAME_POOL_SIZE - NamePool->Count, NamePool->Names + NamePool->Count);\n"
+    "      NamePool->Count = GEN_NAME_POOL_SIZE;\n"
+    "    }\n"
+    "    for (GLsizei Index = 0; Index < Count; ++Index)\n"
+    "    {\n"
+    "      Names[Index] = NamePool->Names[--NamePool->Count];\n"
+    "    }\n"
+    "    Result = 1;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Deletes the names still waiting in the pools of the current context. Call\n"
+    "// it with the context current before destroying it.\n"
+    "static inline void %sOpenGLFreeNamePools()\n"
+    "{\n"
+    "  for (int Pool = 0; Pool < GEN_POOL_COUNT; ++Pool)\n"
+    "  {\n"
+    "    GEN_NamePool* NamePool = GEN_NamePools->Pools + Pool;\n"
+    "    if (NamePool->Count)\n"
+    "    {\n"
+    "      GEN_NamesProc Delete = (GEN_NamesProc)GEN_PROCS[GEN_NamePoolProcs[Pool][1]];\n"
+    "      Delete(NamePool->Count, NamePool->Names);\n"
+    "      NamePool->Count = 0;\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n";
+  fprintf(Output, Generated, Prefix);
+}
+
+// Writes the queue the glDelete* wrappers add names to and OpenGLEndFrame,
+// which makes the deletions of a frame once its fence passed or a number of
+// frames later. Names and fences belong to a context, so each context
+// selects its own queue like its state cache.
+static
+void WriteDeleteQueue(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                      unsigned int FunctionCount, int StateCache)
+{
+  int Fences = 0;
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLString Name = Functions[Index]->FunctionName;
+    Fences += (Name.Length == 11 && Equal(Name, "glFenceSync")) ||
+              (Name.Length == 16 && Equal(Name, "glClientWaitSync")) ||
+              (Name.Length == 12 && Equal(Name, "glDeleteSync"));
+  }
+  Fences = Fences == 3;
+  WriteThreadLocal(Output);
+  const char* Generated =
+    "#include <stdlib.h>\n"
+    "\n"
+    "#ifndef GEN_DELETE_FRAMES\n"
+    "#define GEN_DELETE_FRAMES 2\n"
+    "#endif\n"
+    "\n"
+    "// Queued IDs of functions taking a single name have this bit set.\n"
+    "#define GEN_DELETE_SINGLE 0x80000000u\n"
+    "\n"
+    "typedef void (APIENTRY *GEN_DeleteNamesProc)(GLsizei n, const GLuint *names);\n"
+    "typedef void (APIENTRY *GEN_DeleteNameProc)(GLuint name);\n"
+    "\n"
+    "typedef struct GEN_DeleteBucket\n"
+    "{\n"
+    "  unsigned int* Ids;\n"
+    "  GLuint* Names;\n"
+    "  size_t Count;\n"
+    "  size_t Capacity;\n"
+    "%s"
+    "} GEN_DeleteBucket;\n"
+    "\n"
+    "// Deletions of one context waiting for their frame. Keep one per context.\n"
+    "typedef struct %sOpenGLDeleteQueue\n"
+    "{\n"
+    "  GEN_DeleteBucket Buckets[GEN_DELETE_FRAMES + 1];\n"
+    "  unsigned int Frame;\n"
+    "} %sOpenGLDeleteQueue;\n"
+    "\n"
+    "static %sOpenGLDeleteQueue GEN_DefaultDeleteQueue;\n"
+    "static GEN_THREAD_LOCAL %sOpenGLDeleteQueue* GEN_DeleteQueue = &GEN_DefaultDeleteQueue;\n"
+    "\n"
+    "// Selects the delete queue of the context current on the calling thread.\n"
+    "// Passing null selects the default queue.\n"
+    "static inline void %sOpenGLMakeDeleteQueueCurrent(%sOpenGLDeleteQueue* Queue)\n"
+    "{\n"
+    "  GEN_DeleteQueue = Queue ? Queue : &GEN_DefaultDeleteQueue;\n"
+    "}\n"
+    "\n"
+    "// Drops the names and fences in Queue without deleting them, for contexts\n"
+    "// that are gone. Keeps the memory.\n"
+    "static inline void GEN_ForgetDeletes(%sOpenGLDeleteQueue* Queue)\n"
+    "{\n"
+    "  for (int Frame = 0; Frame <= GEN_DELETE_FRAMES; ++Frame)\n"
+    "  {\n"
+    "    Queue->Buckets[Frame].Count = 0;\n"
+    "%s"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Makes the deletions in Bucket, one call for each run of names deleted\n"
+    "// by the same function.\n"
+    "static void GEN_FlushDeletes(GEN_DeleteBucket* Bucket)\n"
+    "{\n"
+    "  size_t Start = 0;\n"
+    "  while (Start < Bucket->Count)\n"
+    "  {\n"
+    "    unsigned int Id = Bucket->Ids[Start];\n"
+    "    size_t End = Start + 1;\n"
+    "    if (Id & GEN_DELETE_SINGLE)\n"
+    "    {\n"
+    "      ((GEN_DeleteNameProc)GEN_PROCS[Id & ~GEN_DELETE_SINGLE])(Bucket->Names[Start]);\n"
+    "    }\n"
+    "    else\n"
+    "    {\n"
+    "      while (End < Bucket->Count && Bucket->Ids[End] == Id)\n"
+    "      {\n"
+    "        End++;\n"
+    "      }\n"
+    "      ((GEN_DeleteNamesProc)GEN_PROCS[Id])((GLsizei)(End - Start), Bucket->Names + Start);\n"
+    "    }\n"
+    "    Start = End;\n"
+    "  }\n"
+    "%s"
+    "  Bucket->Count = 0;\n"
+    "}\n"
+    "\n"
+    "static void GEN_QueueDeletes(unsigned int Id, GLsizei Count, const GLuint* Names)\n"
+    "{\n"
+    "  GEN_DeleteBucket* Bucket = GEN_DeleteQueue->Buckets + GEN_DeleteQueue->Frame;\n"
+    "  if (Bucket->Count + (size_t)Count > Bucket->Capacity)\n"
+    "  {\n"
+    "    size_t Capacity = Bucket->Capacity ? Bucket->Capacity*2 : 256;\n"
+    "    while (Capacity < Bucket->Count + (size_t)Count)\n"
+    "    {\n"
+    "      Capacity *= 2;\n"
+    "    }\n"
+    "    unsigned int* Ids = (unsigned int*)realloc(Bucket->Ids, Capacity*sizeof(unsigned int));\n"
+    "    Bucket->Ids = Ids ? Ids : Bucket->Ids;\n"
+    "    GLuint* Queued = Ids ? (GLuint*)realloc(Bucket->Names, Capacity*sizeof(GLuint)) : 0;\n"
+    "    Bucket->Names = Queued ? Queued : Bucket->Names;\n"
+    "    if (!Queued)\n"
+    "    {\n"
+    "      GEN_FlushDeletes(Bucket);\n"
+    "      if (Id & GEN_DELETE_SINGLE)\n"
+    "      {\n"
+    "        ((GEN_DeleteNameProc)GEN_PROCS[Id & ~GEN_DELETE_SINGLE])(*Names);\n"
+    "      }\n"
+    "      else\n"
+    "      {\n"
+    "        ((GEN_DeleteNamesProc)GEN_PROCS[Id])(Count, Names);\n"
+    "      }\n"
+    "      return;\n"
+    "    }\n"
+    "    Bucket->Capacity = Capacity;\n"
+    "  }\n"
+    "  for (GLsizei Index = 0; Index < Count; ++Index)\n"
+    "  {\n"
+    "    if (Names[Index])\n"
+    "    {\n"
+    "      Bucket->Ids[Bucket->Count] = Id;\n"
+    "      Bucket->Names[Bucket->Count++] = Names[Index];\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "%s"
+    "// Call once per frame with the context current, e.g. after swapping buffers.\n"
+    "// Deletions made through the wrappers during the frame happen once the GPU\n"
+    "// is done with the frame%s, and at the latest GEN_DELETE_FRAMES\n"
+    "// frames later. Until then deleted objects stay bound where they were.\n"
+    "static inline void %sOpenGLEndFrame()\n"
+    "{\n"
+    "  %sOpenGLDeleteQueue* Queue = GEN_DeleteQueue;\n"
+    "%s"
+    "  Queue->Frame = (Queue->Frame + 1) %% (GEN_DELETE_FRAMES + 1);\n"
+    "  for (int Frame = 0; Frame <= GEN_DELETE_FRAMES; ++Frame)\n"
+    "  {\n"
+    "    GEN_DeleteBucket* Bucket = Queue->Buckets + Frame;\n"
+    "    if (Bucket->Count && (Frame == (int)Queue->Frame%s))\n"
+    "    {\n"
+    "      GEN_FlushDeletes(Bucket);\n"
+    "%s"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Makes all deletions queued for the current context now, e.g. before\n"
+    "// destroying it.\n"
+    "static inline void %sOpenGLFlushDeletes()\n"
+    "{\n"
+    "  for (int Frame = 0; Frame <= GEN_DELETE_FRAMES; ++Frame)\n"
+    "  {\n"
+    "    GEN_FlushDeletes(GEN_DeleteQueue->Buckets + Frame);\n"
+    "  }\n"
+    "%s"
+    "}\n"
+    "\n";
+  char Invalidate[256] = "";
+  char InvalidateFrame[256] = "";
+  if (StateCache)
+  {
+    //NOTE: The driver unbinds names when they are really deleted, which the
+    // state cache can't follow, so it starts over.
+    sprintf(Invalidate, "  %sOpenGLInvalidateStateCache();\n", Prefix);
+    sprintf(InvalidateFrame, "      %sOpenGLInvalidateStateCache();\n", Prefix);
+  }
+  fprintf(Output, Generated,
+          Fences ? "  GLsync Fence;\n" : "",
+          Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix,
+          Fences ? "    Queue->Buckets[Frame].Fence = 0;\n" : "",
+          Fences ? "  if (Bucket->Fence)\n  {\n    GEN_glDeleteSync(Bucket->Fence);\n    Bucket->Fence = 0;\n  }\n" : "",
+          Fences ? "static int GEN_DeleteFenceSignaled(GLsync Fence)\n"
+                   "{\n"
+                   "  GLenum Status = GEN_glClientWaitSync(Fence, 0, 0);\n"
+                   "  return Status == GL_ALREADY_SIGNALED || Status == GL_CONDITION_SATISFIED;\n"
+                   "}\n"
+                   "\n" : "",
+          Fences ? " or when a fence shows it is" : "",
+          Prefix, Prefix,
+          Fences ? "  GEN_DeleteBucket* Current = Queue->Buckets + Queue->Frame;\n"
+                   "  if (Current->Count && !Current->Fence && GEN_glFenceSync)\n"
+                   "  {\n"
+                   "    Current->Fence = GEN_glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);\n"
+                   "  }\n" : "",
+          Fences ? " ||\n        (Bucket->Fence && GEN_DeleteFenceSignaled(Bucket->Fence))" : "",
+          InvalidateFrame, Prefix, Invalidate);
+}
+
+// Writes the per-thread call statistics used by -instrument wrappers.
+static
+void WriteInstrumentation(FILE* Output)
+{
+  WriteAtomics(Output);
+  WriteThreadLocal(Output);
+  const char* Generated =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#if defined(GEN_INSTRUMENT_RDTSC) && defined(_MSC_VER)\n"
+    "#include <intrin.h>\n"
+    "#define GEN_TICKS_UNIT \"cycles\"\n"
+    "#elif defined(GEN_INSTRUMENT_RDTSC)\n"
+    "#include <x86intrin.h>\n"
+    "#define GEN_TICKS_UNIT \"cycles\"\n"
+    "#elif defined(_WIN32)\n"
+    "#define GEN_TICKS_UNIT \"qpc\"\n"
+    "#else\n"
+    "#include <time.h>\n"
+    "#define GEN_TICKS_UNIT \"ns\"\n"
+    "#endif\n\n"
+    "static inline unsigned long long GEN_Ticks()\n"
+    "{\n"
+    "#if defined(GEN_INSTRUMENT_RDTSC)\n"
+    "  return __rdtsc();\n"
+    "#elif defined(_WIN32)\n"
+    "  LARGE_INTEGER Counter;\n"
+    "  QueryPerformanceCounter(&Counter);\n"
+    "  return (unsigned long long)Counter.QuadPart;\n"
+    "#elif defined(CLOCK_MONOTONIC)\n"
+    "  struct timespec Time;\n"
+    "  clock_gettime(CLOCK_MONOTONIC, &Time);\n"
+    "  return (unsigned long long)Time.tv_sec*1000000000ull + (unsigned long long)Time.tv_nsec;\n"
+    "#else\n"
+    "  // Strict ISO C hides the POSIX clocks without _POSIX_C_SOURCE, fall back\n"
+    "  // to the C11 calendar clock.\n"
+    "  struct timespec Time;\n"
+    "  timespec_get(&Time, TIME_UTC);\n"
+    "  return (unsigned long long)Time.tv_sec*1000000000ull + (unsigned long long)Time.tv_nsec;\n"
+    "#endif\n"
+    "}\n\n"
+    "typedef struct GEN_CallStats\n"
+    "{\n"
+    "  unsigned long long Calls;\n"
+    "  unsigned long long Ticks;\n"
+    "} GEN_CallStats;\n\n"
+    "// One table per thread, aligned and padded to a cache line so threads\n"
+    "// never write to the same line.\n"
+    "typedef struct GEN_ThreadStats\n"
+    "{\n"
+    "  GEN_CallStats Functions[GEN_PROC_COUNT];\n"
+    "  struct GEN_ThreadStats* Next;\n"
+    "  char Padding[64];\n"
+    "} GEN_ThreadStats;\n\n"
+    "static GEN_ThreadStats* volatile GEN_StatsList;\n"
+    "static GEN_THREAD_LOCAL GEN_ThreadStats* GEN_LocalStats;\n\n"
+    "static GEN_ThreadStats* GEN_CreateThreadStats()\n"
+    "{\n"
+    "  char* Memory = (char*)calloc(1, sizeof(GEN_ThreadStats) + 64);\n"
+    "  GEN_ThreadStats* Stats = (GEN_ThreadStats*)(Memory + (64 - ((size_t)Memory & 63)));\n"
+    "  GEN_ThreadStats* Head;\n"
+    "  do\n"
+    "  {\n"
+    "    Head = (GEN_ThreadStats*)GEN_AtomicLoadAcquirePointer(&GEN_StatsList);\n"
+    "    Stats->Next = Head;\n"
+    "  } while (!GEN_AtomicCompareExchangePointer(&GEN_StatsList, Head, Stats));\n"
+    "  GEN_LocalStats = Stats;\n"
+    "  return Stats;\n"
+    "}\n\n"
+    "static inline void GEN_RecordCall(int Id, unsigned long long Start)\n"
+    "{\n"
+    "  unsigned long long End = GEN_Ticks();\n"
+    "  GEN_ThreadStats* Stats = GEN_LocalStats;\n"
+    "  if (!Stats)\n"
+    "  {\n"
+    "    Stats = GEN_CreateThreadStats();\n"
+    "  }\n"
+    "  Stats->Functions[Id].Calls++;\n"
+    "  Stats->Functions[Id].Ticks += End - Start;\n"
+    "}\n\n"
+    "// Define GEN_NO_INSTRUMENT before including this file to compile the\n"
+    "// instrumentation out of the wrappers.\n"
+    "#ifdef GEN_NO_INSTRUMENT\n"
+    "#define GEN_INSTRUMENT_BEGIN()\n"
+    "#define GEN_INSTRUMENT_END(Id)\n"
+    "#else\n"
+    "#define GEN_INSTRUMENT_BEGIN() unsigned long long GEN_Start = GEN_Ticks()\n"
+    "#define GEN_INSTRUMENT_END(Id) GEN_RecordCall((Id), GEN_Start)\n"
+    "#endif\n\n";
+  fprintf(Output, "%s", Generated);
+}
+
+// Writes OpenGLDumpStats and OpenGLResetStats. Needs the name blob.
+static
+void WriteInstrumentationReport(FILE* Output, const char* Prefix)
+{
+  const char* Generated =
+    "typedef struct GEN_StatsEntry\n"
+    "{\n"
+    "  int Id;\n"
+    "  unsigned long long Calls;\n"
+    "  unsigned long long Ticks;\n"
+    "} GEN_StatsEntry;\n\n"
+    "static int GEN_CompareStats(const void* A, const void* B)\n"
+    "{\n"
+    "  const GEN_StatsEntry* E1 = (const GEN_StatsEntry*)A;\n"
+    "  const GEN_StatsEntry* E2 = (const GEN_StatsEntry*)B;\n"
+    "  int Result = (E1->Ticks < E2->Ticks) - (E1->Ticks > E2->Ticks);\n"
+    "  if (!Result)\n"
+    "  {\n"
+    "    Result = (E1->Calls < E2->Calls) - (E1->Calls > E2->Calls);\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n\n"
+    "// Prints calls and accumulated time of every called function summed over\n"
+    "// all threads, most expensive first. Pass a non zero Json to get a JSON\n"
+    "// array instead of a table. Call it while no other thread is calling OpenGL.\n"
+    "static inline void %sOpenGLDumpStats(FILE* File, int Json)\n"
+    "{\n"
+    "  GEN_StatsEntry Entries[GEN_PROC_COUNT];\n"
+    "  unsigned long long TotalCalls = 0;\n"
+    "  unsigned long long TotalTicks = 0;\n"
+    "  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "  {\n"
+    "    Entries[Index].Id = Index;\n"
+    "    Entries[Index].Calls = 0;\n"
+    "    Entries[Index].Ticks = 0;\n"
+    "  }\n"
+    "  for (GEN_ThreadStats* Stats = GEN_StatsList; Stats; Stats = Stats->Next)\n"
+    "  {\n"
+    "    for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "    {\n"
+    "      Entries[Index].Calls += Stats->Functions[Index].Calls;\n"
+    "      Entries[Index].Ticks += Stats->Functions[Index].Ticks;\n"
+    "      TotalCalls += Stats->Functions[Index].Calls;\n"
+    "      TotalTicks += Stats->Functions[Index].Ticks;\n"
+    "    }\n"
+    "  }\n"
+    "  qsort(Entries, GEN_PROC_COUNT, sizeof(GEN_StatsEntry), GEN_CompareStats);\n"
+    "  if (Json)\n"
+    "  {\n"
+    "    fprintf(File, \"{\\\"unit\\\": \\\"%%s\\\", \\\"functions\\\": [\", GEN_TICKS_UNIT);\n"
+    "  }\n"
+    "  else\n"
+    "  {\n"
+    "    fprintf(File, \"%%-40s %%12s %%16s %%7s %%10s\\n\", \"function\", \"calls\", GEN_TICKS_UNIT, \"%%\", \"avg\");\n"
+    "  }\n"
+    "  int Written = 0;\n"
+    "  for (int Index = 0; Index < GEN_PROC_COUNT && Entries[Index].Calls; ++Index)\n"
+    "  {\n"
+    "    GEN_StatsEntry* Entry = Entries + Index;\n"
+    "    const char* Name = GEN_ProcNames + GEN_ProcNameOffsets[Entry->Id];\n"
+    "    if (Json)\n"
+    "    {\n"
+    "      fprintf(File, \"%%s\\n  {\\\"name\\\": \\\"%%s\\\", \\\"calls\\\": %%llu, \\\"ticks\\\": %%llu}\",\n"
+    "              Written ? \",\" : \"\", Name, Entry->Calls, Entry->Ticks);\n"
+    "    }\n"
+    "    else\n"
+    "    {\n"
+    "      fprintf(File, \"%%-40s %%12llu %%16llu %%6.2f%%%% %%10.1f\\n\", Name, Entry->Calls, Entry->Ticks,\n"
+    "              TotalTicks ? 100.0*(double)Entry->Ticks/(double)TotalTicks : 0.0,\n"
+    "              (double)Entry->Ticks/(double)Entry->Calls);\n"
+    "    }\n"
+    "    Written++;\n"
+    "  }\n"
+    "  if (Json)\n"
+    "  {\n"
+    "    fprintf(File, \"\\n], \\\"calls\\\": %%llu, \\\"ticks\\\": %%llu}\\n\", TotalCalls, TotalTicks);\n"
+    "  }\n"
+    "  else\n"
+    "  {\n"
+    "    fprintf(File, \"%%-40s %%12llu %%16llu\\n\", \"total\", TotalCalls, TotalTicks);\n"
+    "  }\n"
+    "}\n\n"
+    "// Clears the statistics of all threads.\n"
+    "static inline void %sOpenGLResetStats()\n"
+    "{\n"
+    "  for (GEN_ThreadStats* Stats = GEN_StatsList; Stats; Stats = Stats->Next)\n"
+    "  {\n"
+    "    for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "    {\n"
+    "      Stats->Functions[Index].Calls = 0;\n"
+    "      Stats->Functions[Index].Ticks = 0;\n"
+    "    }\n"
+    "  }\n"
+    "}\n\n";
+  fprintf(Output, Generated, Prefix, Prefix);
+}
+
+// Writes the function that appends a call and its arguments to an encoder.
+static
+void WriteEncoder(FILE* Output, GLArbToken* ArbToken)
+{
+  GLParameter Parameters[MAX_PARAMETERS];
+  int Count = GetParameters(ArbToken->Parameters, Parameters);
+  GLString Name = ArbToken->FunctionName;
+  GLString List = GetParameterList(ArbToken->Parameters);
+  fprintf(Output, "static void GEN_Encode_%" PRI_STR "(GEN_Encoder* Encoder",
+          Name.Length, Name.Chars);
+  if (Count)
+  {
+    fprintf(Output, ", %" PRI_STR, List.Length - 2, List.Chars + 1);
+  }
+  fprintf(Output, ")\n{\n");
+  fprintf(Output, "  GEN_EncodeBegin(Encoder, GEN_ID_%" PRI_STR ", %d);\n",
+          Name.Length, Name.Chars, Count);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    GLString Argument = Parameters[Index].Name;
+    char Size[256];
+    switch (GetArgumentKind(Name, Parameters, Count, Index, Size))
+    {
+      case ArgumentString:
+      {
+        fprintf(Output, "  GEN_EncodePutData(Encoder, %" PRI_STR ", %" PRI_STR " ? strlen(%" PRI_STR ") + 1 : 0);\n",
+                Argument.Length, Argument.Chars, Argument.Length, Argument.Chars,
+                Argument.Length, Argument.Chars);
+      } break;
+      case ArgumentStrings:
+      {
+        fprintf(Output, "  GEN_EncodePutStrings(Encoder, %" PRI_STR ", %s);\n",
+                Argument.Length, Argument.Chars, Size);
+      } break;
+      case ArgumentData:
+      {
+        fprintf(Output, "  GEN_EncodePutData(Encoder, %" PRI_STR ", %s);\n",
+                Argument.Length, Argument.Chars, Size);
+      } break;
+      case ArgumentPixels:
+      {
+        fprintf(Output, "  if (GEN_UnpackBufferBound())\n"
+                        "    GEN_EncodePutOffset(Encoder, %" PRI_STR ");\n"
+                        "  else\n"
+                        "    GEN_EncodePutData(Encoder, %" PRI_STR ", %s);\n",
+                Argument.Length, Argument.Chars, Argument.Length, Argument.Chars, Size);
+      } break;
+      default:
+      {
+        fprintf(Output, "  GEN_EncodePut(Encoder, &%" PRI_STR ", sizeof(%" PRI_STR "));\n",
+                Argument.Length, Argument.Chars, Argument.Length, Argument.Chars);
+      } break;
+    }
+  }
+  fprintf(Output, "  GEN_EncodeEnd(Encoder);\n}\n");
+}
+
+// Writes the switch case that decodes a recorded call and makes it through
+// the pointer table, or through the wrappers for command buffers.
+static
+void WriteReplayCase(FILE* Output, GLArbToken* ArbToken, int Commands)
+{
+  GLParameter Parameters[MAX_PARAMETERS];
+  int Count = GetParameters(ArbToken->Parameters, Parameters);
+  GLString Name = ArbToken->FunctionName;
+  char Arguments[1024];
+  GetArgumentNames(ArbToken->Parameters, Arguments);
+  fprintf(Output, "    case GEN_ID_%" PRI_STR ":\n    {\n", Name.Length, Name.Chars);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    fprintf(Output, "      %" PRI_STR ";\n",
+            Parameters[Index].Declaration.Length, Parameters[Index].Declaration.Chars);
+  }
+  fprintf(Output, "      Record.Data = Record.Slots + %d;\n", 8*Count);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    GLParameter* Parameter = Parameters + Index;
+    char Size[256];
+    switch (GetArgumentKind(Name, Parameters, Count, Index, Size))
+    {
+      case ArgumentString:
+      case ArgumentData:
+      case ArgumentPixels:
+      {
+        fprintf(Output, "      %" PRI_STR " = (%" PRI_STR ")GEN_ReplayGetData(&Record);\n",
+                Parameter->Name.Length, Parameter->Name.Chars,
+                Parameter->Type.Length, Parameter->Type.Chars);
+      } break;
+      case ArgumentStrings:
+      {
+        fprintf(Output, "      %" PRI_STR " = (%" PRI_STR ")GEN_ReplayGetStrings(&Record);\n",
+                Parameter->Name.Length, Parameter->Name.Chars,
+                Parameter->Type.Length, Parameter->Type.Chars);
+      } break;
+      case ArgumentAddress:
+      {
+        fprintf(Output, "      %" PRI_STR " = (%" PRI_STR ")GEN_ReplayGetAddress(&Record);\n",
+                Parameter->Name.Length, Parameter->Name.Chars,
+                Parameter->Type.Length, Parameter->Type.Chars);
+      } break;
+      default:
+      {
+        fprintf(Output, "      GEN_ReplayGet(&Record, &%" PRI_STR ", sizeof(%" PRI_STR "));\n",
+                Parameter->Name.Length, Parameter->Name.Chars,
+                Parameter->Name.Length, Parameter->Name.Chars);
+      } break;
+    }
+  }
+  //NOTE: Scratch memory stands in for pointers that weren't recorded, as long
+  // as what the call writes through them fits.
+  for (int Index = 0; Index < Count && !Commands; ++Index)
+  {
+    GLParameter* Parameter = Parameters + Index;
+    char Size[256];
+    if (GetArgumentKind(Name, Parameters, Count, Index, Size) == ArgumentAddress && *Size)
+    {
+      fprintf(Output, "      if (%s > GEN_REPLAY_SCRATCH_SIZE)\n"
+                      "        %" PRI_STR " = 0;\n",
+              Size, Parameter->Name.Length, Parameter->Name.Chars);
+    }
+  }
+  fprintf(Output, "      %s%s%" PRI_STR "(%s);\n",
+          ReturnsVoid(ArbToken) ? "" : "(void)", Commands ? "" : "GEN_",
+          Name.Length, Name.Chars, Arguments);
+  for (int Index = 0; Index < Count; ++Index)
+  {
+    GLParameter* Parameter = Parameters + Index;
+    char Size[256];
+    if (GetArgumentKind(Name, Parameters, Count, Index, Size) == ArgumentStrings)
+    {
+      fprintf(Output, "      free((void*)%" PRI_STR ");\n", Parameter->Name.Length, Parameter->Name.Chars);
+    }
+  }
+  fprintf(Output, "    } break;\n");
+}
+
+// Writes the record encoding shared by -capture and -commands.
+static
+void WriteEncoding(FILE* Output)
+{
+  const char* Generated =
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "// Growable buffer of call records. Record layout: 32-bit function ID, 32-bit\n"
+    "// record size, one 8 byte slot per argument, then the data copied for\n"
+    "// pointer arguments, 8 byte aligned.\n"
+    "typedef struct GEN_Encoder\n"
+    "{\n"
+    "  unsigned char* Data;\n"
+    "  size_t Used;\n"
+    "  size_t Capacity;\n"
+    "  size_t Record;\n"
+    "  size_t Slots;\n"
+    "} GEN_Encoder;\n"
+    "\n"
+    "static inline void GEN_EncodeReserve(GEN_Encoder* Encoder, size_t Size)\n"
+    "{\n"
+    "  if (Encoder->Used + Size > Encoder->Capacity)\n"
+    "  {\n"
+    "    size_t Capacity = Encoder->Capacity ? Encoder->Capacity : 256;\n"
+    "    while (Capacity < Encoder->Used + Size)\n"
+    "    {\n"
+    "      Capacity *= 2;\n"
+    "    }\n"
+    "    Encoder->Data = (unsigned char*)realloc(Encoder->Data, Capacity);\n"
+    "    Encoder->Capacity = Capacity;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "static inline void GEN_EncodeBegin(GEN_Encoder* Encoder, unsigned int Id, int ArgumentCount)\n"
+    "{\n"
+    "  size_t Size = 8 + 8*(size_t)ArgumentCount;\n"
+    "  GEN_EncodeReserve(Encoder, Size);\n"
+    "  Encoder->Record = Encoder->Used;\n"
+    "  memset(Encoder->Data + Encoder->Record, 0, Size);\n"
+    "  memcpy(Encoder->Data + Encoder->Record, &Id, 4);\n"
+    "  Encoder->Slots = Encoder->Record + 8;\n"
+    "  Encoder->Used += Size;\n"
+    "}\n"
+    "\n"
+    "static inline void GEN_EncodePut(GEN_Encoder* Encoder, const void* Value, size_t Size)\n"
+    "{\n"
+    "  memcpy(Encoder->Data + Encoder->Slots, Value, Size);\n"
+    "  Encoder->Slots += 8;\n"
+    "}\n"
+    "\n"
+    "static inline void GEN_EncodePutData(GEN_Encoder* Encoder, const void* Data, size_t Size)\n"
+    "{\n"
+    "  unsigned long long Length = Data ? (unsigned long long)Size : ~0ull;\n"
+    "  GEN_EncodePut(Encoder, &Length, sizeof(Length));\n"
+    "  if (Data)\n"
+    "  {\n"
+    "    size_t Aligned = (Size + 7) & ~(size_t)7;\n"
+    "    GEN_EncodeReserve(Encoder, Aligned);\n"
+    "    memcpy(Encoder->Data + Encoder->Used, Data, Size);\n"
+    "    memset(Encoder->Data + Encoder->Used + Size, 0, Aligned - Size);\n"
+    "    Encoder->Used += Aligned;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Buffer offsets, e.g. pixels while a GL_PIXEL_UNPACK_BUFFER is bound, are\n"
+    "// recorded as a ~1 length followed by their value.\n"
+    "static inline void GEN_EncodePutOffset(GEN_Encoder* Encoder, const void* Offset)\n"
+    "{\n"
+    "  unsigned long long Length = ~1ull;\n"
+    "  unsigned long long Value = (unsigned long long)(size_t)Offset;\n"
+    "  GEN_EncodePut(Encoder, &Length, sizeof(Length));\n"
+    "  GEN_EncodeReserve(Encoder, sizeof(Value));\n"
+    "  memcpy(Encoder->Data + Encoder->Used, &Value, sizeof(Value));\n"
+    "  Encoder->Used += sizeof(Value);\n"
+    "}\n"
+    "\n"
+    "static inline size_t GEN_StringLength(const char* Text, int Length)\n"
+    "{\n"
+    "  size_t Result = Length < 0 ? strlen(Text) : (size_t)Length;\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Arrays of Count strings, each Lengths[Index] bytes or zero terminated when\n"
+    "// Lengths is null or the length negative. Data layout: the count, the offset\n"
+    "// of each string from the start of the data or ~0 for null, then the strings\n"
+    "// zero terminated.\n"
+    "static inline void GEN_EncodePutStrings(GEN_Encoder* Encoder, const char* const* Strings, int Count, const int* Lengths)\n"
+    "{\n"
+    "  size_t Total = Strings && Count > 0 ? (size_t)Count : 0;\n"
+    "  size_t Size = 8 + 8*Total;\n"
+    "  for (size_t Index = 0; Index < Total; ++Index)\n"
+    "  {\n"
+    "    if (Strings[Index])\n"
+    "    {\n"
+    "      Size += GEN_StringLength(Strings[Index], Lengths ? Lengths[Index] : -1) + 1;\n"
+    "    }\n"
+    "  }\n"
+    "  unsigned long long Length = Strings ? (unsigned long long)Size : ~0ull;\n"
+    "  GEN_EncodePut(Encoder, &Length, sizeof(Length));\n"
+    "  if (Strings)\n"
+    "  {\n"
+    "    size_t Aligned = (Size + 7) & ~(size_t)7;\n"
+    "    GEN_EncodeReserve(Encoder, Aligned);\n"
+    "    unsigned char* Data = Encoder->Data + Encoder->Used;\n"
+    "    memset(Data, 0, Aligned);\n"
+    "    unsigned long long Value = (unsigned long long)Total;\n"
+    "    memcpy(Data, &Value, sizeof(Value));\n"
+    "    size_t At = 8 + 8*Total;\n"
+    "    for (size_t Index = 0; Index < Total; ++Index)\n"
+    "    {\n"
+    "      Value = ~0ull;\n"
+    "      if (Strings[Index])\n"
+    "      {\n"
+    "        size_t Chars = GEN_StringLength(Strings[Index], Lengths ? Lengths[Index] : -1);\n"
+    "        memcpy(Data + At, Strings[Index], Chars);\n"
+    "        Value = (unsigned long long)At;\n"
+    "        At += Chars + 1;\n"
+    "      }\n"
+    "      memcpy(Data + 8 + 8*Index, &Value, sizeof(Value));\n"
+    "    }\n"
+    "    Encoder->Used += Aligned;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "static inline void GEN_EncodeEnd(GEN_Encoder* Encoder)\n"
+    "{\n"
+    "  unsigned int Size = (unsigned int)(Encoder->Used - Encoder->Record);\n"
+    "  memcpy(Encoder->Data + Encoder->Record + 4, &Size, 4);\n"
+    "}\n"
+    "\n"
+    "// Size of a texel of format and type, as the clear functions read one and\n"
+    "// images are made of them. Combinations that aren't listed are errors the\n"
+    "// driver doesn't read data for.\n"
+    "static inline size_t GEN_TexelSize(unsigned int Format, unsigned int Type)\n"
+    "{\n"
+    "  size_t Components = 0;\n"
+    "  switch (Format)\n"
+    "  {\n"
+    "    case 0x1901: // GL_STENCIL_INDEX\n"
+    "    case 0x1902: // GL_DEPTH_COMPONENT\n"
+    "    case 0x1903: // GL_RED\n"
+    "    case 0x1904: // GL_GREEN\n"
+    "    case 0x1905: // GL_BLUE\n"
+    "    case 0x1906: // GL_ALPHA\n"
+    "    case 0x8D94: // GL_RED_INTEGER\n"
+    "    case 0x8D95: // GL_GREEN_INTEGER\n"
+    "    case 0x8D96: // GL_BLUE_INTEGER\n"
+    "    case 0x1909: // GL_LUMINANCE\n"
+    "      Components = 1; break;\n"
+    "    case 0x8227: // GL_RG\n"
+    "    case 0x190A: // GL_LUMINANCE_ALPHA\n"
+    "    case 0x8228: // GL_RG_INTEGER\n"
+    "    case 0x84F9: // GL_DEPTH_STENCIL\n"
+    "      Components = 2; break;\n"
+    "    case 0x1907: // GL_RGB\n"
+    "    case 0x80E0: // GL_BGR\n"
+    "    case 0x8D98: // GL_RGB_INTEGER\n"
+    "    case 0x8D9A: // GL_BGR_INTEGER\n"
+    "      Components = 3; break;\n"
+    "    case 0x1908: // GL_RGBA\n"
+    "    case 0x80E1: // GL_BGRA\n"
+    "    case 0x8D99: // GL_RGBA_INTEGER\n"
+    "    case 0x8D9B: // GL_BGRA_INTEGER\n"
+    "      Components = 4; break;\n"
+    "  }\n"
+    "  size_t Result = 0;\n"
+    "  switch (Type)\n"
+    "  {\n"
+    "    case 0x1400: // GL_BYTE\n"
+    "    case 0x1401: // GL_UNSIGNED_BYTE\n"
+    "      Result = Components; break;\n"
+    "    case 0x1402: // GL_SHORT\n"
+    "    case 0x1403: // GL_UNSIGNED_SHORT\n"
+    "    case 0x140B: // GL_HALF_FLOAT\n"
+    "      Result = 2*Components; break;\n"
+    "    case 0x1404: // GL_INT\n"
+    "    case 0x1405: // GL_UNSIGNED_INT\n"
+    "    case 0x1406: // GL_FLOAT\n"
+    "      Result = 4*Components; break;\n"
+    "    case 0x8032: // GL_UNSIGNED_BYTE_3_3_2\n"
+    "    case 0x8362: // GL_UNSIGNED_BYTE_2_3_3_REV\n"
+    "      Result = Components ? 1 : 0; break;\n"
+    "    case 0x8033: // GL_UNSIGNED_SHORT_4_4_4_4\n"
+    "    case 0x8034: // GL_UNSIGNED_SHORT_5_5_5_1\n"
+    "    case 0x8363: // GL_UNSIGNED_SHORT_5_6_5\n"
+    "    case 0x8364: // GL_UNSIGNED_SHORT_5_6_5_REV\n"
+    "    case 0x8365: // GL_UNSIGNED_SHORT_4_4_4_4_REV\n"
+    "    case 0x8366: // GL_UNSIGNED_SHORT_1_5_5_5_REV\n"
+    "      Result = Components ? 2 : 0; break;\n"
+    "    case 0x8035: // GL_UNSIGNED_INT_8_8_8_8\n"
+    "    case 0x8036: // GL_UNSIGNED_INT_10_10_10_2\n"
+    "    case 0x8367: // GL_UNSIGNED_INT_8_8_8_8_REV\n"
+    "    case 0x8368: // GL_UNSIGNED_INT_2_10_10_10_REV\n"
+    "    case 0x84FA: // GL_UNSIGNED_INT_24_8\n"
+    "    case 0x8C3B: // GL_UNSIGNED_INT_10F_11F_11F_REV\n"
+    "    case 0x8C3E: // GL_UNSIGNED_INT_5_9_9_9_REV\n"
+    "      Result = Components ? 4 : 0; break;\n"
+    "    case 0x8DAD: // GL_FLOAT_32_UNSIGNED_INT_24_8_REV\n"
+    "      Result = Components ? 8 : 0; break;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Bytes spanned by an image of Width x Height x Depth texels whose rows start\n"
+    "// Alignment aligned, RowLength texels apart and ImageHeight rows per image\n"
+    "// when those aren't zero.\n"
+    "static inline size_t GEN_ImageSize(int Width, int Height, int Depth, unsigned int Format, unsigned int Type,\n"
+    "                                   int Alignment, int RowLength, int ImageHeight)\n"
+    "{\n"
+    "  size_t Result = 0;\n"
+    "  size_t Texel = GEN_TexelSize(Format, Type);\n"
+    "  if (Width > 0 && Height > 0 && Depth > 0 && Texel)\n"
+    "  {\n"
+    "    size_t Align = Alignment > 0 ? (size_t)Alignment : 1;\n"
+    "    size_t Row = ((size_t)(RowLength > 0 ? RowLength : Width)*Texel + Align - 1)/Align*Align;\n"
+    "    size_t Image = (size_t)(ImageHeight > 0 ? ImageHeight : Height)*Row;\n"
+    "    Result = (size_t)(Depth - 1)*Image + (size_t)(Height - 1)*Row + (size_t)Width*Texel;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Bytes an upload of an image reads from client memory under the current\n"
+    "// unpack state, including the skipped pixels, rows and images.\n"
+    "static inline size_t GEN_UnpackImageSize(int Width, int Height, int Depth, unsigned int Format, unsigned int Type)\n"
+    "{\n"
+    "  int State[6] = {4, 0, 0, 0, 0, 0};\n"
+    "#ifdef GEN_glGetIntegerv\n"
+    "  // GL_UNPACK_ALIGNMENT, ROW_LENGTH, IMAGE_HEIGHT, SKIP_PIXELS, SKIP_ROWS and\n"
+    "  // SKIP_IMAGES.\n"
+    "  unsigned int Names[6] = {0x0CF5, 0x0CF2, 0x806E, 0x0CF4, 0x0CF3, 0x806D};\n"
+    "  for (int Index = 0; Index < 6 && GEN_glGetIntegerv; ++Index)\n"
+    "  {\n"
+    "    GEN_glGetIntegerv(Names[Index], State + Index);\n"
+    "  }\n"
+    "#endif\n"
+    "  size_t Result = 0;\n"
+    "  if (Width > 0 && Height > 0 && Depth > 0)\n"
+    "  {\n"
+    "    Result = GEN_ImageSize(Width + State[3], Height + State[4], Depth + State[5], Format, Type,\n"
+    "                           State[0], State[1] ? State[1] : Width, State[2] ? State[2] : Height);\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "static inline int GEN_UnpackBufferBound()\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "#ifdef GEN_glGetIntegerv\n"
+    "  if (GEN_glGetIntegerv)\n"
+    "  {\n"
+    "    GEN_glGetIntegerv(0x88EF, &Result); // GL_PIXEL_UNPACK_BUFFER_BINDING\n"
+    "  }\n"
+    "#endif\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Size of a debug string that is Length bytes, or zero terminated if Length\n"
+    "// is negative.\n"
+    "static inline size_t GEN_StringSize(const char* Text, int Length)\n"
+    "{\n"
+    "  size_t Result = 0;\n"
+    "  if (Text)\n"
+    "  {\n"
+    "    Result = Length < 0 ? strlen(Text) + 1 : (size_t)Length;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "typedef struct GEN_ReplayRecord\n"
+    "{\n"
+    "  const unsigned char* Slots;\n"
+    "  const unsigned char* Data;\n"
+    "} GEN_ReplayRecord;\n"
+    "\n"
+    "static inline void GEN_ReplayGet(GEN_ReplayRecord* Record, void* Value, size_t Size)\n"
+    "{\n"
+    "  memcpy(Value, Record->Slots, Size);\n"
+    "  Record->Slots += 8;\n"
+    "}\n"
+    "\n"
+    "static inline const void* GEN_ReplayGetData(GEN_ReplayRecord* Record)\n"
+    "{\n"
+    "  const void* Result = 0;\n"
+    "  unsigned long long Length;\n"
+    "  GEN_ReplayGet(Record, &Length, sizeof(Length));\n"
+    "  if (Length == ~1ull)\n"
+    "  {\n"
+    "    unsigned long long Offset;\n"
+    "    memcpy(&Offset, Record->Data, sizeof(Offset));\n"
+    "    Result = (const void*)(size_t)Offset;\n"
+    "    Record->Data += sizeof(Offset);\n"
+    "  }\n"
+    "  else if (Length != ~0ull)\n"
+    "  {\n"
+    "    Result = Record->Data;\n"
+    "    Record->Data += (Length + 7) & ~7ull;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Points into the record data. Free the array after the call.\n"
+    "static inline const char** GEN_ReplayGetStrings(GEN_ReplayRecord* Record)\n"
+    "{\n"
+    "  const char** Result = 0;\n"
+    "  const unsigned char* Data = (const unsigned char*)GEN_ReplayGetData(Record);\n"
+    "  if (Data)\n"
+    "  {\n"
+    "    unsigned long long Count;\n"
+    "    memcpy(&Count, Data, sizeof(Count));\n"
+    "    Result = (const char**)malloc((Count ? (size_t)Count : 1)*sizeof(*Result));\n"
+    "    for (size_t Index = 0; Index < Count; ++Index)\n"
+    "    {\n"
+    "      unsigned long long At;\n"
+    "      memcpy(&At, Data + 8 + 8*Index, sizeof(At));\n"
+    "      Result[Index] = At == ~0ull ? 0 : (const char*)Data + At;\n"
+    "    }\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n";
+  fprintf(Output, "%s", Generated);
+}
+
+// Writes the capture ring buffers used by -capture.
+static
+void WriteCapture(FILE* Output)
+{
+  WriteAtomics(Output);
+  WriteThreadLocal(Output);
+  const char* Generated =
+    "#include <stdio.h>\n"
+    "#ifdef _WIN32\n"
+    "#define GEN_Sleep() Sleep(1)\n"
+    "#else\n"
+    "#include <pthread.h>\n"
+    "#include <time.h>\n"
+    "// Strict ISO C hides nanosleep without _POSIX_C_SOURCE, fall back to C11.\n"
+    "#ifndef CLOCK_MONOTONIC\n"
+    "#include <threads.h>\n"
+    "#endif\n"
+    "static void GEN_Sleep()\n"
+    "{\n"
+    "  struct timespec Time = {0, 1000000};\n"
+    "#ifdef CLOCK_MONOTONIC\n"
+    "  nanosleep(&Time, 0);\n"
+    "#else\n"
+    "  thrd_sleep(&Time, 0);\n"
+    "#endif\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "#ifndef GEN_CAPTURE_RING_SIZE\n"
+    "#define GEN_CAPTURE_RING_SIZE (1 << 20)\n"
+    "#endif\n"
+    "\n"
+    "// Single producer, single consumer ring. The calling thread appends records,\n"
+    "// the flush thread writes them to the trace file.\n"
+    "typedef struct GEN_CaptureRing\n"
+    "{\n"
+    "  volatile long Head;\n"
+    "  char Padding0[64];\n"
+    "  volatile long Tail;\n"
+    "  char Padding1[64];\n"
+    "  unsigned int Index;\n"
+    "  struct GEN_CaptureRing* Next;\n"
+    "  unsigned char Data[GEN_CAPTURE_RING_SIZE];\n"
+    "} GEN_CaptureRing;\n"
+    "\n"
+    "static volatile long GEN_Capturing;\n"
+    "static volatile long GEN_CaptureStop;\n"
+    "static FILE* GEN_CaptureFile;\n"
+    "static GEN_CaptureRing* volatile GEN_CaptureRings;\n"
+    "static GEN_THREAD_LOCAL GEN_CaptureRing* GEN_LocalRing;\n"
+    "static GEN_THREAD_LOCAL GEN_Encoder GEN_CaptureEncoder;\n"
+    "\n"
+    "static GEN_CaptureRing* GEN_CreateCaptureRing()\n"
+    "{\n"
+    "  GEN_CaptureRing* Ring = (GEN_CaptureRing*)calloc(1, sizeof(GEN_CaptureRing));\n"
+    "  GEN_CaptureRing* Head;\n"
+    "  do\n"
+    "  {\n"
+    "    Head = (GEN_CaptureRing*)GEN_AtomicLoadAcquirePointer(&GEN_CaptureRings);\n"
+    "    Ring->Next = Head;\n"
+    "    Ring->Index = Head ? Head->Index + 1 : 0;\n"
+    "  } while (!GEN_AtomicCompareExchangePointer(&GEN_CaptureRings, Head, Ring));\n"
+    "  GEN_LocalRing = Ring;\n"
+    "  return Ring;\n"
+    "}\n"
+    "\n"
+    "// Appends whole records or nothing, so the flush thread never writes half a\n"
+    "// record. Waits for the flush thread to make room while capturing. Records\n"
+    "// that don't fit in an empty ring are dropped.\n"
+    "static void GEN_CaptureWrite(const unsigned char* Data, size_t Size)\n"
+    "{\n"
+    "  GEN_CaptureRing* Ring = GEN_LocalRing;\n"
+    "  if (!Ring)\n"
+    "  {\n"
+    "    Ring = GEN_CreateCaptureRing();\n"
+    "  }\n"
+    "  if (Size && Size < GEN_CAPTURE_RING_SIZE)\n"
+    "  {\n"
+    "    long Head = Ring->Head;\n"
+    "    size_t Free = 0;\n"
+    "    for (;;)\n"
+    "    {\n"
+    "      long Tail = GEN_AtomicLoadAcquire(&Ring->Tail);\n"
+    "      Free = (size_t)((Tail + GEN_CAPTURE_RING_SIZE - Head - 1) % GEN_CAPTURE_RING_SIZE);\n"
+    "      if (Free >= Size || !GEN_AtomicLoadAcquire(&GEN_Capturing))\n"
+    "      {\n"
+    "        break;\n"
+    "      }\n"
+    "      GEN_Yield();\n"
+    "    }\n"
+    "    if (Free >= Size)\n"
+    "    {\n"
+    "      size_t First = (size_t)(GEN_CAPTURE_RING_SIZE - Head);\n"
+    "      First = First < Size ? First : Size;\n"
+    "      memcpy(Ring->Data + Head, Data, First);\n"
+    "      memcpy(Ring->Data, Data + First, Size - First);\n"
+    "      GEN_AtomicStoreRelease(&Ring->Head, (long)(((size_t)Head + Size) % GEN_CAPTURE_RING_SIZE));\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "static void GEN_CaptureCommit()\n"
+    "{\n"
+    "  GEN_CaptureWrite(GEN_CaptureEncoder.Data, GEN_CaptureEncoder.Used);\n"
+    "  GEN_CaptureEncoder.Used = 0;\n"
+    "}\n"
+    "\n";
+  fprintf(Output, "%s", Generated);
+}
+
+// Writes the command buffer type and the recording state used by -commands.
+static
+void WriteCommands(FILE* Output, const char* Prefix)
+{
+  WriteThreadLocal(Output);
+  const char* Generated =
+    "// Linear arena of recorded calls. Any thread can record into its own buffer,\n"
+    "// the thread owning the context executes them in the order it chooses.\n"
+    "typedef struct %sOpenGLCommandBuffer\n"
+    "{\n"
+    "  GEN_Encoder Encoder;\n"
+    "} %sOpenGLCommandBuffer;\n"
+    "\n"
+    "static GEN_THREAD_LOCAL GEN_Encoder* GEN_CommandEncoder;\n"
+    "\n"
+    "// Records the calls the calling thread makes through the wrappers into\n"
+    "// Buffer instead of making them, until OpenGLEndCommands. Data behind\n"
+    "// pointer arguments is copied. Calls that return a value, write through a\n"
+    "// pointer, take pixels or a pointer of unknown size can't be recorded and\n"
+    "// must not be made while recording. Previous contents of Buffer are\n"
+    "// dropped, its memory kept.\n"
+    "static inline void %sOpenGLBeginCommands(%sOpenGLCommandBuffer* Buffer)\n"
+    "{\n"
+    "  Buffer->Encoder.Used = 0;\n"
+    "  GEN_CommandEncoder = &Buffer->Encoder;\n"
+    "}\n"
+    "\n"
+    "static inline void %sOpenGLEndCommands()\n"
+    "{\n"
+    "  GEN_CommandEncoder = 0;\n"
+    "}\n"
+    "\n"
+    "static inline void %sOpenGLFreeCommands(%sOpenGLCommandBuffer* Buffer)\n"
+    "{\n"
+    "  free(Buffer->Encoder.Data);\n"
+    "  memset(Buffer, 0, sizeof(*Buffer));\n"
+    "}\n"
+    "\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+}
+
+// Writes OpenGLExecuteCommands. Calls go through the wrappers, so it comes
+// after them.
+static
+void WriteCommandExecution(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                           unsigned int FunctionCount)
+{
+  const char* Generated =
+    "\n"
+    "static void GEN_ExecuteCall(unsigned int Id, const unsigned char* Data)\n"
+    "{\n"
+    "  GEN_ReplayRecord Record;\n"
+    "  Record.Slots = Data + 8;\n"
+    "  Record.Data = 0;\n"
+    "  switch (Id)\n"
+    "  {\n";
+  fprintf(Output, "%s", Generated);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    if (IsDeferrable(Functions[Index]))
+    {
+      WriteReplayCase(Output, Functions[Index], 1);
+    }
+  }
+  fprintf(Output, "    default:\n    {\n    } break;\n  }\n}\n\n");
+  Generated =
+    "// Makes the calls recorded in Buffer on the calling thread, which must have\n"
+    "// the context current. Returns the number of calls made.\n"
+    "static inline size_t %sOpenGLExecuteCommands(const %sOpenGLCommandBuffer* Buffer)\n"
+    "{\n"
+    "  size_t Result = 0;\n"
+    "  GEN_Encoder* Recording = GEN_CommandEncoder;\n"
+    "  GEN_CommandEncoder = 0;\n"
+    "  for (size_t Offset = 0; Offset < Buffer->Encoder.Used; ++Result)\n"
+    "  {\n"
+    "    unsigned int Id;\n"
+    "    unsigned int Size;\n"
+    "    memcpy(&Id, Buffer->Encoder.Data + Offset, 4);\n"
+    "    memcpy(&Size, Buffer->Encoder.Data + Offset + 4, 4);\n"
+    "    GEN_ExecuteCall(Id, Buffer->Encoder.Data + Offset);\n"
+    "    Offset += Size;\n"
+    "  }\n"
+    "  GEN_CommandEncoder = Recording;\n"
+    "  return Result;\n"
+    "}\n";
+  fprintf(Output, Generated, Prefix, Prefix);
+}
+
+// Writes OpenGLCaptureStart/Stop, the replayer and the flush thread. Needs
+// the name blob.
+static
+void WriteCaptureReplay(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                        unsigned int FunctionCount)
+{
+  const char* Generated =
+    "// Writes everything the rings hold as chunks of a 32-bit ring index, a 32-bit\n"
+    "// size and the bytes. Returns non zero if anything was written.\n"
+    "static int GEN_FlushCaptureRings()\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "  GEN_CaptureRing* Rings = (GEN_CaptureRing*)GEN_AtomicLoadAcquirePointer(&GEN_CaptureRings);\n"
+    "  for (GEN_CaptureRing* Ring = Rings; Ring; Ring = Ring->Next)\n"
+    "  {\n"
+    "    long Tail = Ring->Tail;\n"
+    "    long Head = GEN_AtomicLoadAcquire(&Ring->Head);\n"
+    "    if (Head != Tail)\n"
+    "    {\n"
+    "      unsigned int Header[2];\n"
+    "      Header[0] = Ring->Index;\n"
+    "      Header[1] = (unsigned int)((Head + GEN_CAPTURE_RING_SIZE - Tail) %% GEN_CAPTURE_RING_SIZE);\n"
+    "      fwrite(Header, sizeof(Header), 1, GEN_CaptureFile);\n"
+    "      if (Head > Tail)\n"
+    "      {\n"
+    "        fwrite(Ring->Data + Tail, (size_t)(Head - Tail), 1, GEN_CaptureFile);\n"
+    "      }\n"
+    "      else\n"
+    "      {\n"
+    "        fwrite(Ring->Data + Tail, (size_t)(GEN_CAPTURE_RING_SIZE - Tail), 1, GEN_CaptureFile);\n"
+    "        fwrite(Ring->Data, (size_t)Head, 1, GEN_CaptureFile);\n"
+    "      }\n"
+    "      GEN_AtomicStoreRelease(&Ring->Tail, Head);\n"
+    "      Result = 1;\n"
+    "    }\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "static void GEN_FlushCaptureLoop()\n"
+    "{\n"
+    "  while (!GEN_AtomicLoadAcquire(&GEN_CaptureStop))\n"
+    "  {\n"
+    "    if (!GEN_FlushCaptureRings())\n"
+    "    {\n"
+    "      GEN_Sleep();\n"
+    "    }\n"
+    "  }\n"
+    "  while (GEN_FlushCaptureRings())\n"
+    "  {\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "#ifdef _WIN32\n"
+    "static HANDLE GEN_CaptureThread;\n"
+    "static DWORD WINAPI GEN_CaptureThreadProc(LPVOID Param)\n"
+    "{\n"
+    "  (void)Param;\n"
+    "  GEN_FlushCaptureLoop();\n"
+    "  return 0;\n"
+    "}\n"
+    "static void GEN_StartCaptureThread()\n"
+    "{\n"
+    "  GEN_CaptureThread = CreateThread(0, 0, GEN_CaptureThreadProc, 0, 0, 0);\n"
+    "}\n"
+    "static void GEN_JoinCaptureThread()\n"
+    "{\n"
+    "  WaitForSingleObject(GEN_CaptureThread, INFINITE);\n"
+    "  CloseHandle(GEN_CaptureThread);\n"
+    "}\n"
+    "#else\n"
+    "static pthread_t GEN_CaptureThread;\n"
+    "static void* GEN_CaptureThreadProc(void* Param)\n"
+    "{\n"
+    "  (void)Param;\n"
+    "  GEN_FlushCaptureLoop();\n"
+    "  return 0;\n"
+    "}\n"
+    "static void GEN_StartCaptureThread()\n"
+    "{\n"
+    "  pthread_create(&GEN_CaptureThread, 0, GEN_CaptureThreadProc, 0);\n"
+    "}\n"
+    "static void GEN_JoinCaptureThread()\n"
+    "{\n"
+    "  pthread_join(GEN_CaptureThread, 0);\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "// Starts recording every OpenGL call made through the wrappers to Filename.\n"
+    "// Returns zero if the file can't be created.\n"
+    "static inline int %sOpenGLCaptureStart(const char* Filename)\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "  FILE* File = fopen(Filename, \"wb\");\n"
+    "  if (File)\n"
+    "  {\n"
+    "    unsigned int Header[4] = {0x54474c47, 2, GEN_PROC_COUNT, sizeof(GEN_ProcNames)};\n"
+    "    fwrite(Header, sizeof(Header), 1, File);\n"
+    "    fwrite(GEN_ProcNames, sizeof(GEN_ProcNames), 1, File);\n"
+    "    GEN_CaptureFile = File;\n"
+    "    GEN_AtomicStoreRelease(&GEN_CaptureStop, 0);\n"
+    "    GEN_AtomicStoreRelease(&GEN_Capturing, 1);\n"
+    "    GEN_StartCaptureThread();\n"
+    "    Result = 1;\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Stops recording, flushes all pending calls and closes the trace file. Call\n"
+    "// it while no other thread is calling OpenGL.\n"
+    "static inline void %sOpenGLCaptureStop()\n"
+    "{\n"
+    "  if (GEN_CaptureFile)\n"
+    "  {\n"
+    "    GEN_AtomicStoreRelease(&GEN_Capturing, 0);\n"
+    "    GEN_AtomicStoreRelease(&GEN_CaptureStop, 1);\n"
+    "    GEN_JoinCaptureThread();\n"
+    "    fclose(GEN_CaptureFile);\n"
+    "    GEN_CaptureFile = 0;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "#ifndef GEN_REPLAY_SCRATCH_SIZE\n"
+    "#define GEN_REPLAY_SCRATCH_SIZE (1 << 24)\n"
+    "#endif\n"
+    "#ifndef GEN_REPLAY_MAX_THREADS\n"
+    "#define GEN_REPLAY_MAX_THREADS 64\n"
+    "#endif\n"
+    "\n"
+    "// Pointers of unknown size, mostly ones the call writes through, point to\n"
+    "// zeroed scratch memory. Calls that would write more than\n"
+    "// GEN_REPLAY_SCRATCH_SIZE bytes through them get a null pointer instead.\n"
+    "static unsigned char* GEN_ReplayScratch;\n"
+    "\n"
+    "static void* GEN_ReplayGetAddress(GEN_ReplayRecord* Record)\n"
+    "{\n"
+    "  unsigned long long Address;\n"
+    "  GEN_ReplayGet(Record, &Address, sizeof(Address));\n"
+    "  return Address ? GEN_ReplayScratch : 0;\n"
+    "}\n"
+    "\n";
+  fprintf(Output, Generated, Prefix, Prefix);
+  Generated =
+    "static void GEN_ReplayCall(unsigned int Id, const unsigned char* Data)\n"
+    "{\n"
+    "  GEN_ReplayRecord Record;\n"
+    "  Record.Slots = Data + 8;\n"
+    "  Record.Data = 0;\n"
+    "  switch (Id)\n"
+    "  {\n";
+  fprintf(Output, "%s", Generated);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    WriteReplayCase(Output, Functions[Index], 0);
+  }
+  fprintf(Output, "    default:\n    {\n    } break;\n  }\n}\n\n");
+  Generated =
+    "typedef struct GEN_ReplayStream\n"
+    "{\n"
+    "  unsigned char* Data;\n"
+    "  size_t Used;\n"
+    "  size_t Capacity;\n"
+    "} GEN_ReplayStream;\n"
+    "\n"
+    "// Plays a trace recorded with OpenGLCaptureStart back through the pointer\n"
+    "// table. Calls of each recorded thread are replayed in order, threads are\n"
+    "// interleaved at flush granularity. Returns the number of calls replayed or\n"
+    "// -1 if the trace doesn't match the functions of this file, is corrupt or\n"
+    "// was recorded by more than GEN_REPLAY_MAX_THREADS threads.\n"
+    "static inline long long %sOpenGLReplayTrace(const char* Filename)\n"
+    "{\n"
+    "  long long Result = -1;\n"
+    "  FILE* File = fopen(Filename, \"rb\");\n"
+    "  if (File)\n"
+    "  {\n"
+    "    unsigned int Header[4];\n"
+    "    char Names[sizeof(GEN_ProcNames)];\n"
+    "    if (fread(Header, sizeof(Header), 1, File) == 1 &&\n"
+    "        Header[0] == 0x54474c47 && Header[1] == 2 &&\n"
+    "        Header[2] == GEN_PROC_COUNT && Header[3] == sizeof(GEN_ProcNames) &&\n"
+    "        fread(Names, sizeof(Names), 1, File) == 1 &&\n"
+    "        memcmp(Names, GEN_ProcNames, sizeof(Names)) == 0)\n"
+    "    {\n"
+    "      GEN_ReplayStream Streams[GEN_REPLAY_MAX_THREADS];\n"
+    "      memset(Streams, 0, sizeof(Streams));\n"
+    "      if (!GEN_ReplayScratch)\n"
+    "      {\n"
+    "        GEN_ReplayScratch = (unsigned char*)calloc(1, GEN_REPLAY_SCRATCH_SIZE);\n"
+    "      }\n"
+    "      Result = 0;\n"
+    "      unsigned int Chunk[2];\n"
+    "      while (Result >= 0 && fread(Chunk, sizeof(Chunk), 1, File) == 1)\n"
+    "      {\n"
+    "        if (Chunk[0] >= GEN_REPLAY_MAX_THREADS)\n"
+    "        {\n"
+    "          Result = -1;\n"
+    "          break;\n"
+    "        }\n"
+    "        GEN_ReplayStream* Stream = Streams + Chunk[0];\n"
+    "        if (Stream->Used + Chunk[1] > Stream->Capacity)\n"
+    "        {\n"
+    "          Stream->Capacity = (Stream->Used + Chunk[1])*2;\n"
+    "          Stream->Data = (unsigned char*)realloc(Stream->Data, Stream->Capacity);\n"
+    "        }\n"
+    "        if (fread(Stream->Data + Stream->Used, Chunk[1], 1, File) != 1)\n"
+    "        {\n"
+    "          break;\n"
+    "        }\n"
+    "        Stream->Used += Chunk[1];\n"
+    "        size_t Offset = 0;\n"
+    "        while (Stream->Used - Offset >= 8)\n"
+    "        {\n"
+    "          unsigned int Id;\n"
+    "          unsigned int Size;\n"
+    "          memcpy(&Id, Stream->Data + Offset, 4);\n"
+    "          memcpy(&Size, Stream->Data + Offset + 4, 4);\n"
+    "          if (Size < 8)\n"
+    "          {\n"
+    "            Result = -1;\n"
+    "            break;\n"
+    "          }\n"
+    "          if (Stream->Used - Offset < Size)\n"
+    "          {\n"
+    "            break;\n"
+    "          }\n"
+    "          GEN_ReplayCall(Id, Stream->Data + Offset);\n"
+    "          Offset += Size;\n"
+    "          Result++;\n"
+    "        }\n"
+    "        memmove(Stream->Data, Stream->Data + Offset, Stream->Used - Offset);\n"
+    "        Stream->Used -= Offset;\n"
+    "      }\n"
+    "      for (int Index = 0; Index < GEN_REPLAY_MAX_THREADS; ++Index)\n"
+    "      {\n"
+    "        free(Streams[Index].Data);\n"
+    "      }\n"
+    "    }\n"
+    "    fclose(File);\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "// Compile this file with GEN_REPLAYER_MAIN defined to get a replayer that\n"
+    "// plays a trace against a null backend and reports the CPU time it took.\n"
+    "#ifdef GEN_REPLAYER_MAIN\n"
+    "#include <time.h>\n"
+    "static void GEN_NullProc()\n"
+    "{\n"
+    "}\n"
+    "int main(int ArgCount, char** Args)\n"
+    "{\n"
+    "  int Result = 1;\n"
+    "  if (ArgCount < 2)\n"
+    "  {\n"
+    "    printf(\"Usage: %%s <tracefile> [iterations]\\n\", Args[0]);\n"
+    "  }\n"
+    "  else\n"
+    "  {\n"
+    "    int Iterations = ArgCount > 2 ? atoi(Args[2]) : 1;\n"
+    "    for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "    {\n"
+    "      GEN_PROCS[Index] = (%sOpenGLProc)GEN_NullProc;\n"
+    "    }\n"
+    "    for (int Iteration = 0; Iteration < Iterations; ++Iteration)\n"
+    "    {\n"
+    "      clock_t Start = clock();\n"
+    "      long long Calls = %sOpenGLReplayTrace(Args[1]);\n"
+    "      double Seconds = (double)(clock() - Start)/CLOCKS_PER_SEC;\n"
+    "      if (Calls < 0)\n"
+    "      {\n"
+    "        printf(\"Can't replay %%s: it doesn't match this file, is corrupt or has more than %%d threads\\n\",\n"
+    "               Args[1], GEN_REPLAY_MAX_THREADS);\n"
+    "        break;\n"
+    "      }\n"
+    "      printf(\"%%lld calls in %%.3f ms (%%.1f ns/call)\\n\", Calls, Seconds*1000.0,\n"
+    "             Calls ? Seconds*1e9/(double)Calls : 0.0);\n"
+    "      Result = 0;\n"
+    "    }\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "#endif\n"
+    "\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix);
+}
+
+// Writes the extension enum, the bitset filled by OpenGLInit and the perfect
+// hash table that maps extension names reported by the driver to bits.
+static
+void WriteExtensions(FILE* Output, const char* Prefix, GLArbToken** Extensions,
+                     unsigned int ExtensionCount)
+{
+  //NOTE: Searches for a seed that maps every used extension to its own slot
+  // of a table with at least twice as many slots as extensions.
+  unsigned int TableSize = 2;
+  while (TableSize < 2*ExtensionCount)
+  {
+    TableSize *= 2;
+  }
+  unsigned short* Table = (unsigned short*)calloc(TableSize, sizeof(unsigned short));
+  unsigned int Seed = 0;
+  for (;;)
+  {
+    memset(Table, 0, TableSize*sizeof(unsigned short));
+    unsigned int Index = 0;
+    for (; Index < ExtensionCount; ++Index)
+    {
+      GLString Name = Extensions[Index]->Value;
+      unsigned int Slot = GetExtensionHash(Name.Chars, Name.Length, Seed) & (TableSize - 1);
+      if (Table[Slot])
+      {
+        break;
+      }
+      Table[Slot] = (unsigned short)(Index + 1);
+    }
+    if (Index == ExtensionCount)
+    {
+      break;
+    }
+    if (++Seed == 4096)
+    {
+      Seed = 0;
+      TableSize *= 2;
+      Table = (unsigned short*)realloc(Table, TableSize*sizeof(unsigned short));
+    }
+  }
+
+  fprintf(Output, "\n#include <string.h>\n\ntypedef enum %sOpenGLExtension\n{\n", Prefix);
+  for (unsigned int Index = 0; Index < ExtensionCount; ++Index)
+  {
+    GLString Name = Extensions[Index]->Value;
+    fprintf(Output, "  %sOpenGLExtension_%" PRI_STR ",\n", Prefix, Name.Length - 3, Name.Chars + 3);
+  }
+  const char* Generated =
+    "  %sOpenGLExtensionCount\n"
+    "} %sOpenGLExtension;\n"
+    "\n"
+    "static unsigned int GEN_Extensions[(%sOpenGLExtensionCount + 31)/32];\n"
+    "\n"
+    "// Returns non zero if the driver reported Extension when OpenGLInit ran.\n"
+    "static inline int %sOpenGLHasExtension(%sOpenGLExtension Extension)\n"
+    "{\n"
+    "  return (GEN_Extensions[Extension >> 5] >> (Extension & 31)) & 1;\n"
+    "}\n"
+    "\n"
+    "static const char GEN_ExtensionNames[] =\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix);
+  unsigned int Offset = 0;
+  for (unsigned int Index = 0; Index < ExtensionCount; ++Index)
+  {
+    GLString Name = Extensions[Index]->Value;
+    fprintf(Output, "  \"%" PRI_STR "\\0\"%s\n", Name.Length, Name.Chars,
+            Index + 1 == ExtensionCount ? ";" : "");
+    Offset += Name.Length + 1;
+  }
+  const char* OffsetType = Offset > 0xFFFF ? "unsigned int" : "unsigned short";
+  fprintf(Output, "static const %s GEN_ExtensionNameOffsets[%sOpenGLExtensionCount] =\n{",
+          OffsetType, Prefix);
+  Offset = 0;
+  for (unsigned int Index = 0; Index < ExtensionCount; ++Index)
+  {
+    fprintf(Output, "%s%u,", (Index % 12) == 0 ? "\n  " : " ", Offset);
+    Offset += Extensions[Index]->Value.Length + 1;
+  }
+  fprintf(Output, "\n};\n\n// Extension index plus one, zero for empty slots.\n"
+                  "static const unsigned short GEN_ExtensionSlots[%u] =\n{", TableSize);
+  for (unsigned int Index = 0; Index < TableSize; ++Index)
+  {
+    fprintf(Output, "%s%u,", (Index % 16) == 0 ? "\n  " : " ", Table[Index]);
+  }
+  fprintf(Output, "\n};\n\n");
+  free(Table);
+
+  Generated =
+    "static void GEN_AddExtension(const char* Name, size_t Length)\n"
+    "{\n"
+    "  unsigned int Hash = 2166136261u ^ %uu;\n"
+    "  for (size_t Index = 0; Index < Length; ++Index)\n"
+    "  {\n"
+    "    Hash = (Hash ^ (unsigned char)Name[Index])*16777619u;\n"
+    "  }\n"
+    "  Hash ^= Hash >> 16;\n"
+    "  unsigned int Slot = GEN_ExtensionSlots[Hash & %uu];\n"
+    "  if (Slot)\n"
+    "  {\n"
+    "    const char* Expected = GEN_ExtensionNames + GEN_ExtensionNameOffsets[Slot - 1];\n"
+    "    if (strncmp(Expected, Name, Length) == 0 && !Expected[Length])\n"
+    "    {\n"
+    "      GEN_Extensions[(Slot - 1) >> 5] |= 1u << ((Slot - 1) & 31);\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "// Fills the extension bitset from the current context, with glGetStringi on\n"
+    "// OpenGL 3.0 and above or by splitting GL_EXTENSIONS before.\n"
+    "static void GEN_LoadExtensions()\n"
+    "{\n"
+    "  memset(GEN_Extensions, 0, sizeof(GEN_Extensions));\n"
+    "  GLint Count = 0;\n"
+    "  if (GEN_glGetStringi && GEN_glGetIntegerv)\n"
+    "  {\n"
+    "    GEN_glGetIntegerv(GL_NUM_EXTENSIONS, &Count);\n"
+    "    for (GLint Index = 0; Index < Count; ++Index)\n"
+    "    {\n"
+    "      const char* Name = (const char*)GEN_glGetStringi(GL_EXTENSIONS, (GLuint)Index);\n"
+    "      if (Name)\n"
+    "      {\n"
+    "        GEN_AddExtension(Name, strlen(Name));\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "  if (!Count && GEN_glGetString)\n"
+    "  {\n"
+    "    const char* At = (const char*)GEN_glGetString(GL_EXTENSIONS);\n"
+    "    while (At && *At)\n"
+    "    {\n"
+    "      const char* Start = At;\n"
+    "      while (*At && *At != ' ')\n"
+    "      {\n"
+    "        ++At;\n"
+    "      }\n"
+    "      GEN_AddExtension(Start, (size_t)(At - Start));\n"
+    "      while (*At == ' ')\n"
+    "      {\n"
+    "        ++At;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+  fprintf(Output, Generated, Seed, TableSize - 1);
+}
+
+// Writes a stub for every function that reports the first call and returns
+// zero, the bitmask of functions the driver didn't provide and the passes that
+// put the stubs in place of null entries.
+static
+void WriteFallbacks(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                    unsigned int FunctionCount, int Lazy)
+{
+  const char* Generated =
+    "\n"
+    "#ifndef GEN_LOG_MISSING\n"
+    "#include <stdio.h>\n"
+    "#define GEN_LOG_MISSING(Name) fprintf(stderr, \"OpenGL function %%s is not available\\n\", Name)\n"
+    "#endif\n"
+    "\n"
+    "static unsigned int GEN_Missing[(GEN_PROC_COUNT + 31)/32];\n"
+    "static unsigned int GEN_MissingReported[(GEN_PROC_COUNT + 31)/32];\n"
+    "\n"
+    "// Returns non zero if the driver didn't provide Function, e.g.\n"
+    "// OpenGLIsMissing(glBufferStorage). Calls to it do nothing and return zero.\n"
+    "#define %sOpenGLIsMissing(Function) ((GEN_Missing[GEN_ID_##Function >> 5] >> (GEN_ID_##Function & 31)) & 1)\n"
+    "\n"
+    "static void GEN_ReportMissing(int Index)\n"
+    "{\n"
+    "  unsigned int Bit = 1u << (Index & 31);\n"
+    "  if (!(GEN_MissingReported[Index >> 5] & Bit))\n"
+    "  {\n"
+    "    GEN_MissingReported[Index >> 5] |= Bit;\n"
+    "    GEN_LOG_MISSING(GEN_ProcNames + GEN_ProcNameOffsets[Index]);\n"
+    "  }\n"
+    "}\n"
+    "\n";
+  fprintf(Output, Generated, Prefix);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    GLString ReturnType = TrimString(ArbToken->ReturnType);
+    GLString Parameters = GetParameterList(ArbToken->Parameters);
+    fprintf(Output, "static %" PRI_STR " APIENTRY GEN_Missing_%" PRI_STR "%" PRI_STR "\n{\n",
+            ReturnType.Length, ReturnType.Chars,
+            ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+            Parameters.Length, Parameters.Chars);
+    GLParameter Arguments[MAX_PARAMETERS];
+    int Count = GetParameters(ArbToken->Parameters, Arguments);
+    for (int Argument = 0; Argument < Count; ++Argument)
+    {
+      fprintf(Output, "  (void)%" PRI_STR ";\n",
+              Arguments[Argument].Name.Length, Arguments[Argument].Name.Chars);
+    }
+    fprintf(Output, "  GEN_ReportMissing(GEN_ID_%" PRI_STR ");\n%s}\n",
+            ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+            ReturnsVoid(ArbToken) ? "" : "  return 0;\n");
+  }
+  fprintf(Output, "\nstatic const %sOpenGLProc GEN_MissingProcs[GEN_PROC_COUNT] =\n{\n", Prefix);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    fprintf(Output, "  (%sOpenGLProc)GEN_Missing_%" PRI_STR ",\n", Prefix,
+            ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
+  }
+  Generated =
+    "};\n"
+    "\n"
+    "// Points a null entry at its stub. Only misses in the table filled by\n"
+    "// OpenGLInit are recorded.\n"
+    "static void GEN_StubMissingProc(%sOpenGLProc* Procs, int Index)\n"
+    "{\n"
+    "  if (!Procs[Index])\n"
+    "  {\n"
+    "    Procs[Index] = GEN_MissingProcs[Index];\n"
+    "    if (Procs == GEN_Procs)\n"
+    "    {\n"
+    "      GEN_Missing[Index >> 5] |= 1u << (Index & 31);\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+  fprintf(Output, Generated, Prefix);
+  if (!Lazy)
+  {
+    Generated =
+      "\n"
+      "static void GEN_StubMissingProcs(%sOpenGLProc* Procs)\n"
+      "{\n"
+      "  if (Procs == GEN_Procs)\n"
+      "  {\n"
+      "    for (int Index = 0; Index < (GEN_PROC_COUNT + 31)/32; ++Index)\n"
+      "    {\n"
+      "      GEN_Missing[Index] = 0;\n"
+      "    }\n"
+      "  }\n"
+      "  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+      "  {\n"
+      "    GEN_StubMissingProc(Procs, Index);\n"
+      "  }\n"
+      "}\n";
+    fprintf(Output, Generated, Prefix);
+  }
+}
+
+// Writes the helpers that keep linked program binaries in a directory, keyed
+// by the shader sources and the driver that built them.
+static
+void WriteProgramCache(FILE* Output, const char* Prefix)
+{
+  const char* Generated =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#ifdef _WIN32\n"
+    "#include <windows.h>\n"
+    "#else\n"
+    "#include <fcntl.h>\n"
+    "#include <sys/mman.h>\n"
+    "#include <sys/stat.h>\n"
+    "#include <unistd.h>\n"
+    "#endif\n"
+    "\n"
+    "#define GEN_PROGRAM_CACHE_MAGIC 0x4e424c47u\n"
+    "\n"
+    "typedef struct GEN_ProgramHeader\n"
+    "{\n"
+    "  unsigned int Magic;\n"
+    "  GLenum Format;\n"
+    "  unsigned long long Key;\n"
+    "  unsigned long long Length;\n"
+    "} GEN_ProgramHeader;\n"
+    "\n"
+    "// Hashes the shader sources of a program together with GL_VENDOR, GL_RENDERER\n"
+    "// and GL_VERSION, so binaries built by another driver are never loaded.\n"
+    "static inline unsigned long long %sOpenGLProgramKey(const char* const* Sources, int SourceCount)\n"
+    "{\n"
+    "  unsigned long long Result = GEN_GetDriverIdentity() ^ 14695981039346656037ull;\n"
+    "  for (int Index = 0; Index < SourceCount; ++Index)\n"
+    "  {\n"
+    "    const char* At = Sources[Index];\n"
+    "    do\n"
+    "    {\n"
+    "      Result = (Result ^ (unsigned char)*At)*1099511628211ull;\n"
+    "    } while (*At++);\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "static void GEN_GetProgramPath(char* Path, size_t Size, const char* Directory,\n"
+    "                               unsigned long long Key)\n"
+    "{\n"
+    "  snprintf(Path, Size, \"%%s/%%016llx.glbin\", Directory, Key);\n"
+    "}\n"
+    "\n"
+    "// Maps a file for reading. Returns null if it doesn't exist or is empty.\n"
+    "static const unsigned char* GEN_MapFile(const char* Path, size_t* Size)\n"
+    "{\n"
+    "  const unsigned char* Result = 0;\n"
+    "#ifdef _WIN32\n"
+    "  HANDLE File = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,\n"
+    "                            FILE_ATTRIBUTE_NORMAL, 0);\n"
+    "  if (File != INVALID_HANDLE_VALUE)\n"
+    "  {\n"
+    "    LARGE_INTEGER Length;\n"
+    "    HANDLE Mapping = 0;\n"
+    "    if (GetFileSizeEx(File, &Length) && Length.QuadPart > 0)\n"
+    "    {\n"
+    "      Mapping = CreateFileMappingA(File, 0, PAGE_READONLY, 0, 0, 0);\n"
+    "    }\n"
+    "    if (Mapping)\n"
+    "    {\n"
+    "      Result = (const unsigned char*)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);\n"
+    "      *Size = (size_t)Length.QuadPart;\n"
+    "      CloseHandle(Mapping);\n"
+    "    }\n"
+    "    CloseHandle(File);\n"
+    "  }\n"
+    "#else\n"
+    "  int File = open(Path, O_RDONLY);\n"
+    "  if (File >= 0)\n"
+    "  {\n"
+    "    struct stat Stat;\n"
+    "    if (fstat(File, &Stat) == 0 && Stat.st_size > 0)\n"
+    "    {\n"
+    "      void* Mapped = mmap(0, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);\n"
+    "      Result = Mapped == MAP_FAILED ? 0 : (const unsigned char*)Mapped;\n"
+    "      *Size = (size_t)Stat.st_size;\n"
+    "    }\n"
+    "    close(File);\n"
+    "  }\n"
+    "#endif\n"
+    "  return Result;\n"
+    "}\n"
+    "\n"
+    "static void GEN_UnmapFile(const unsigned char* Data, size_t Size)\n"
+    "{\n"
+    "#ifdef _WIN32\n"
+    "  (void)Size;\n"
+    "  UnmapViewOfFile(Data);\n"
+    "#else\n"
+    "  munmap((void*)Data, Size);\n"
+    "#endif\n"
+    "}\n"
+    "\n"
+    "// Loads the binary cached under Key into Program. Returns non zero if Program\n"
+    "// is linked and ready to use; otherwise compile and link it as usual and call\n"
+    "// OpenGLSaveProgram. Binaries the driver rejects are removed from the cache.\n"
+    "static inline int %sOpenGLLoadProgram(GLuint Program, const char* Directory, unsigned long long Key)\n"
+    "{\n"
+    "  char Path[1024];\n"
+    "  GEN_GetProgramPath(Path, sizeof(Path), Directory, Key);\n"
+    "  size_t Size = 0;\n"
+    "  GLint Linked = 0;\n"
+    "  const unsigned char* Data = GEN_MapFile(Path, &Size);\n"
+    "  if (Data)\n"
+    "  {\n"
+    "    const GEN_ProgramHeader* Header = (const GEN_ProgramHeader*)Data;\n"
+    "    if (Size > sizeof(GEN_ProgramHeader) && Header->Magic == GEN_PROGRAM_CACHE_MAGIC &&\n"
+    "        Header->Key == Key && Header->Length == Size - sizeof(GEN_ProgramHeader))\n"
+    "    {\n"
+    "      GEN_glProgramBinary(Program, Header->Format, Data + sizeof(GEN_ProgramHeader),\n"
+    "                          (GLsizei)Header->Length);\n"
+    "      GEN_glGetProgramiv(Program, GL_LINK_STATUS, &Linked);\n"
+    "    }\n"
+    "    GEN_UnmapFile(Data, Size);\n"
+    "    if (!Linked)\n"
+    "    {\n"
+    "      remove(Path);\n"
+    "    }\n"
+    "  }\n"
+    "  return Linked != 0;\n"
+    "}\n"
+    "\n"
+    "// Writes the binary of the linked Program to the cache under Key. Set\n"
+    "// GL_PROGRAM_BINARY_RETRIEVABLE_HINT with glProgramParameteri before linking,\n"
+    "// so the driver keeps the binary around. Returns non zero on success.\n"
+    "static inline int %sOpenGLSaveProgram(GLuint Program, const char* Directory, unsigned long long Key)\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "  GLint Length = 0;\n"
+    "  GEN_glGetProgramiv(Program, GL_PROGRAM_BINARY_LENGTH, &Length);\n"
+    "  unsigned char* Data = 0;\n"
+    "  if (Length > 0)\n"
+    "  {\n"
+    "    Data = (unsigned char*)malloc(sizeof(GEN_ProgramHeader) + (size_t)Length);\n"
+    "  }\n"
+    "  if (Data)\n"
+    "  {\n"
+    "    GEN_ProgramHeader* Header = (GEN_ProgramHeader*)Data;\n"
+    "    GLsizei Written = 0;\n"
+    "    GLenum Format = 0;\n"
+    "    GEN_glGetProgramBinary(Program, Length, &Written, &Format, Data + sizeof(GEN_ProgramHeader));\n"
+    "    Header->Magic = GEN_PROGRAM_CACHE_MAGIC;\n"
+    "    Header->Format = Format;\n"
+    "    Header->Key = Key;\n"
+    "    Header->Length = (unsigned long long)Written;\n"
+    "    //NOTE: Written to a temporary file that is renamed once complete, so\n"
+    "    // nobody maps half a binary.\n"
+    "    char Path[1024];\n"
+    "    char Temporary[1040];\n"
+    "    GEN_GetProgramPath(Path, sizeof(Path), Directory, Key);\n"
+    "    snprintf(Temporary, sizeof(Temporary), \"%%s.tmp\", Path);\n"
+    "    FILE* File = Written > 0 ? fopen(Temporary, \"wb\") : 0;\n"
+    "    if (File)\n"
+    "    {\n"
+    "      size_t Total = sizeof(GEN_ProgramHeader) + (size_t)Written;\n"
+    "      Result = fwrite(Data, 1, Total, File) == Total;\n"
+    "      Result = fclose(File) == 0 && Result;\n"
+    "#ifdef _WIN32\n"
+    "      remove(Path);\n"
+    "#endif\n"
+    "      Result = Result && rename(Temporary, Path) == 0;\n"
+    "      if (!Result)\n"
+    "      {\n"
+    "        remove(Temporary);\n"
+    "      }\n"
+    "    }\n"
+    "    free(Data);\n"
+    "  }\n"
+    "  return Result;\n"
+    "}\n"
+    "\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix);
+}
+
+// Writes an enum value for each name in Names and the table of the names as
+// the driver knows them.
+static
+void WriteLocationNames(FILE* Output, const char* Prefix, const char* Kind,
+                        GLString* Names, unsigned int Count)
+{
+  fprintf(Output, "typedef enum %sOpenGL%s\n{\n", Prefix, Kind);
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    char EnumName[512];
+    GetLocationEnumName(EnumName, Names[Index]);
+    fprintf(Output, "  %sOpenGL%s_%s,\n", Prefix, Kind, EnumName);
+  }
+  fprintf(Output, "  %sOpenGL%sCount\n} %sOpenGL%s;\n\n", Prefix, Kind, Prefix, Kind);
+  fprintf(Output, "static const char* const GEN_%sNames[%sOpenGL%sCount] =\n{\n", Kind, Prefix, Kind);
+  for (unsigned int Index = 0; Index < Count; ++Index)
+  {
+    fprintf(Output, "  \"%" PRI_STR "\",\n", Names[Index].Length, Names[Index].Chars);
+  }
+  fprintf(Output, "};\n\n");
+}
+
+// Writes the per-program table of uniform and attribute locations for the
+// names the inputs look up with string literals.
+static
+void WriteLocations(FILE* Output, const char* Prefix, GLLocations* Locations)
+{
+  fprintf(Output, "\n");
+  if (Locations->UniformCount)
+  {
+    WriteLocationNames(Output, Prefix, "Uniform", Locations->Uniforms, Locations->UniformCount);
+  }
+  if (Locations->AttributeCount)
+  {
+    WriteLocationNames(Output, Prefix, "Attribute", Locations->Attributes, Locations->AttributeCount);
+  }
+  fprintf(Output, "typedef struct %sOpenGLProgramLocations\n{\n", Prefix);
+  if (Locations->UniformCount)
+  {
+    fprintf(Output, "  GLint Uniforms[%sOpenGLUniformCount];\n", Prefix);
+  }
+  if (Locations->AttributeCount)
+  {
+    fprintf(Output, "  GLint Attributes[%sOpenGLAttributeCount];\n", Prefix);
+  }
+  fprintf(Output,
+          "} %sOpenGLProgramLocations;\n"
+          "\n"
+          "// Looks up every location of the table once, right after Program is linked.\n"
+          "// Names the program doesn't use get -1, like they do from the driver.\n"
+          "static inline void %sOpenGLGetProgramLocations(GLuint Program, %sOpenGLProgramLocations* Locations)\n"
+          "{\n", Prefix, Prefix, Prefix);
+  if (Locations->UniformCount)
+  {
+    fprintf(Output,
+            "  for (int Index = 0; Index < %sOpenGLUniformCount; ++Index)\n"
+            "  {\n"
+            "    Locations->Uniforms[Index] = glGetUniformLocation(Program, GEN_UniformNames[Index]);\n"
+            "  }\n", Prefix);
+  }
+  if (Locations->AttributeCount)
+  {
+    fprintf(Output,
+            "  for (int Index = 0; Index < %sOpenGLAttributeCount; ++Index)\n"
+            "  {\n"
+            "    Locations->Attributes[Index] = glGetAttribLocation(Program, GEN_AttributeNames[Index]);\n"
+            "  }\n", Prefix);
+  }
+  fprintf(Output, "}\n\n");
+}
+
+// Writes the functions that hand the table filled by OpenGLInit to modules
+// reloaded at runtime and bind a module to it.
+static
+void WriteSharedTable(FILE* Output, const char* Prefix, int Fallbacks)
+{
+  const char* Generated =
+    "#include <string.h>\n"
+    "\n"
+    "// Returns the table filled by OpenGLInit. It stays valid until OpenGLShutdown.\n"
+    "%sOpenGLSharedTable* %sOpenGLGetSharedTable()\n"
+    "{\n"
+    "  static %sOpenGLSharedTable Table;\n"
+    "  Table.NamesHash = GEN_PROC_NAMES_HASH;\n"
+    "  Table.Count = GEN_PROC_COUNT;\n"
+    "  Table.Names = GEN_ProcNames;\n"
+    "  Table.Procs = GEN_Procs;\n"
+    "  return &Table;\n"
+    "}\n"
+    "\n"
+    "// Makes calls go through the functions in Table. A module generated from\n"
+    "// the same inputs as its host binds with a single assignment, otherwise the\n"
+    "// functions are copied by name. Nothing is loaded or looked up either way.\n"
+    "// Returns non zero if Table is used directly.\n"
+    "int %sOpenGLBindShared(%sOpenGLSharedTable* Table)\n"
+    "{\n"
+    "  int Result = 0;\n"
+    "  if (Table->NamesHash == GEN_PROC_NAMES_HASH && Table->Count == GEN_PROC_COUNT)\n"
+    "  {\n"
+    "    GEN_BoundProcs = Table->Procs;\n"
+    "    Result = 1;\n"
+    "  }\n"
+    "  else\n"
+    "  {\n"
+    "    for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "    {\n"
+    "      GEN_Procs[Index] = 0;\n"
+    "    }\n"
+    "    const char* Name = Table->Names;\n"
+    "    for (int Shared = 0; Shared < Table->Count; ++Shared)\n"
+    "    {\n"
+    "      for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+    "      {\n"
+    "        if (strcmp(Name, GEN_ProcNames + GEN_ProcNameOffsets[Index]) == 0)\n"
+    "        {\n"
+    "          GEN_Procs[Index] = Table->Procs[Shared];\n"
+    "          break;\n"
+    "        }\n"
+    "      }\n"
+    "      Name += strlen(Name) + 1;\n"
+    "    }\n"
+    "%s"
+    "    GEN_BoundProcs = GEN_Procs;\n"
+    "  }\n"
+    "  GEN_AtomicStoreRelease(&GEN_Published, 1);\n"
+    "  return Result;\n"
+    "}\n\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix,
+          Fallbacks ? "    GEN_StubMissingProcs(GEN_Procs);\n" : "");
+}
+
+// Counts the registry features that own at least one of Functions, which
+// must be ordered by feature.
+static
+unsigned int GetFeatureCount(GLArbToken** Functions, unsigned int FunctionCount)
+{
+  unsigned int Result = 0;
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    if (Functions[Index]->FeatureIndex &&
+        (!Index || Functions[Index - 1]->FeatureIndex != Functions[Index]->FeatureIndex))
+    {
+      Result++;
+    }
+  }
+  return Result;
+}
+
+// Writes the feature enum and bitset, the version or extension each feature
+// needs and the range of function IDs it owns. Unless functions resolve
+// lazily, OpenGLInit only looks up the functions of supported features.
+static
+void WriteFeatures(FILE* Output, const char* Prefix, GLArbToken** Functions,
+                   unsigned int FunctionCount, unsigned int ExtensionCount, int Lazy,
+                   int Fallbacks)
+{
+  fprintf(Output, "\ntypedef enum %sOpenGLFeature\n{\n", Prefix);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    if (ArbToken->FeatureIndex &&
+        (!Index || Functions[Index - 1]->FeatureIndex != ArbToken->FeatureIndex))
+    {
+      fprintf(Output, "  %sOpenGLFeature_%" PRI_STR ",\n", Prefix,
+              ArbToken->Feature.Length - 3, ArbToken->Feature.Chars + 3);
+    }
+  }
+  const char* Generated =
+    "  %sOpenGLFeatureCount\n"
+    "} %sOpenGLFeature;\n"
+    "\n"
+    "static unsigned int GEN_Features[(%sOpenGLFeatureCount + 31)/32];\n"
+    "\n"
+    "// Returns non zero if the context supports the version or extension that\n"
+    "// declares the functions of Feature, as of the last OpenGLInit.\n"
+    "static inline int %sOpenGLHasFeature(%sOpenGLFeature Feature)\n"
+    "{\n"
+    "  return (GEN_Features[Feature >> 5] >> (Feature & 31)) & 1;\n"
+    "}\n"
+    "\n"
+    "typedef struct GEN_FeatureRequirement\n"
+    "{\n"
+    "  unsigned short Major;\n"
+    "  unsigned short Minor;\n"
+    "  int Extension;\n"
+    "} GEN_FeatureRequirement;\n"
+    "\n"
+    "// Version each feature needs, or its extension. Versions have no extension.\n"
+    "static const GEN_FeatureRequirement GEN_FeatureRequirements[%sOpenGLFeatureCount] =\n"
+    "{\n";
+  fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    GLArbToken* ArbToken = Functions[Index];
+    if (ArbToken->FeatureIndex &&
+        (!Index || Functions[Index - 1]->FeatureIndex != ArbToken->FeatureIndex))
+    {
+      int Major, Minor;
+      if (GetFeatureVersion(ArbToken->Feature, &Major, &Minor))
+      {
+        fprintf(Output, "  {%d, %d, -1},\n", Major, Minor);
+      }
+      else
+      {
+        fprintf(Output, "  {0, 0, %sOpenGLExtension_%" PRI_STR "},\n", Prefix,
+                ArbToken->Feature.Length - 3, ArbToken->Feature.Chars + 3);
+      }
+    }
+  }
+  fprintf(Output, "};\n\n// First function ID of each feature. Functions declared outside of any\n"
+                  "// feature come first and are always resolved.\n"
+                  "static const unsigned short GEN_FeatureProcs[%sOpenGLFeatureCount + 1] =\n{",
+          Prefix);
+  unsigned int Count = 0;
+  for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+  {
+    if (Functions[Index]->FeatureIndex &&
+        (!Index || Functions[Index - 1]->FeatureIndex != Functions[Index]->FeatureIndex))
+    {
+      fprintf(Output, "%s%u,", (Count++ % 12) == 0 ? "\n  " : " ", Index);
+    }
+  }
+  fprintf(Output, "%sGEN_PROC_COUNT\n};\n\n", (Count % 12) == 0 ? "\n  " : " ");
+
+  Generated =
+    "// Reads the version from GL_VERSION, which also works before OpenGL 3.0 and\n"
+    "// on OpenGL ES, and fills the feature bitset. Without a context to ask every\n"
+    "// feature counts as supported.\n"
+    "static void GEN_LoadFeatures()\n"
+    "{\n"
+    "  int Major = 0;\n"
+    "  int Minor = 0;\n"
+    "  const char* At = GEN_glGetString ? (const char*)GEN_glGetString(GL_VERSION) : 0;\n"
+    "  while (At && *At && (*At < '0' || *At > '9'))\n"
+    "  {\n"
+    "    ++At;\n"
+    "  }\n"
+    "  while (At && *At >= '0' && *At <= '9')\n"
+    "  {\n"
+    "    Major = Major*10 + (*At++ - '0');\n"
+    "  }\n"
+    "  if (At && *At == '.')\n"
+    "  {\n"
+    "    ++At;\n"
+    "    while (*At >= '0' && *At <= '9')\n"
+    "    {\n"
+    "      Minor = Minor*10 + (*At++ - '0');\n"
+    "    }\n"
+    "  }\n"
+    "%s"
+    "  for (int Index = 0; Index < (%sOpenGLFeatureCount + 31)/32; ++Index)\n"
+    "  {\n"
+    "    GEN_Features[Index] = 0;\n"
+    "  }\n"
+    "  for (int Feature = 0; Feature < %sOpenGLFeatureCount; ++Feature)\n"
+    "  {\n"
+    "    const GEN_FeatureRequirement* Requirement = GEN_FeatureRequirements + Feature;\n"
+    "    int Supported = !Major;\n"
+    "    if (Requirement->Extension < 0)\n"
+    "    {\n"
+    "      Supported |= Major > Requirement->Major ||\n"
+    "                   (Major == Requirement->Major && Minor >= Requirement->Minor);\n"
+    "    }\n"
+    "%s"
+    "    if (Supported)\n"
+    "    {\n"
+    "      GEN_Features[Feature >> 5] |= 1u << (Feature & 31);\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+  char ExtensionCheck[256] = "";
+  if (ExtensionCount)
+  {
+    sprintf(ExtensionCheck,
+            "    else\n"
+            "    {\n"
+            "      Supported |= %sOpenGLHasExtension((%sOpenGLExtension)Requirement->Extension);\n"
+            "    }\n", Prefix, Prefix);
+  }
+  fprintf(Output, Generated, ExtensionCount ? "  GEN_LoadExtensions();\n" : "",
+          Prefix, Prefix, ExtensionCheck);
+
+  if (!Lazy)
+  {
+    //NOTE: The functions needed to find out what the context supports are
+    // resolved up front, every other lookup is skipped for unsupported
+    // features.
+    Generated =
+      "\n"
+      "static void GEN_ResolveAvailableProcs()\n"
+      "{\n"
+      "  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+      "  {\n"
+      "    GEN_Procs[Index] = 0;\n"
+      "  }\n";
+    fprintf(Output, "%s", Generated);
+    const char* Lookups[] = {"glGetString", "glGetIntegerv", "glGetStringi"};
+    for (unsigned int Lookup = 0; Lookup < sizeof(Lookups)/sizeof(*Lookups); ++Lookup)
+    {
+      for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+      {
+        GLString Name = Functions[Index]->FunctionName;
+        if (Name.Length == strlen(Lookups[Lookup]) && Equal(Name, Lookups[Lookup]))
         {
-          AddToken(DefinesHash, Token);
-          *DefinesCount += 1;
+          fprintf(Output, "  GEN_Procs[GEN_ID_%s] = %sOpenGLGetProc(\"%s\");\n",
+                  Lookups[Lookup], Prefix, Lookups[Lookup]);
+        }
+      }
+    }
+    Generated =
+      "  GEN_LoadFeatures();\n"
+      "\n"
+      "  for (int Index = 0; Index < GEN_FeatureProcs[0]; ++Index)\n"
+      "  {\n"
+      "    GEN_Procs[Index] = %sOpenGLGetProc(GEN_ProcNames + GEN_ProcNameOffsets[Index]);\n"
+      "  }\n"
+      "  for (int Feature = 0; Feature < %sOpenGLFeatureCount; ++Feature)\n"
+      "  {\n"
+      "    int Supported = %sOpenGLHasFeature((%sOpenGLFeature)Feature);\n"
+      "    for (int Index = GEN_FeatureProcs[Feature]; Index < GEN_FeatureProcs[Feature + 1]; ++Index)\n"
+      "    {\n"
+      "      if (!Supported)\n"
+      "      {\n"
+      "        GEN_Procs[Index] = 0;\n"
+      "      }\n"
+      "      else if (!GEN_Procs[Index])\n"
+      "      {\n"
+      "        GEN_Procs[Index] = %sOpenGLGetProc(GEN_ProcNames + GEN_ProcNameOffsets[Index]);\n"
+      "      }\n"
+      "    }\n"
+      "  }\n"
+      "%s"
+      "}\n";
+    fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix,
+            Fallbacks ? "  GEN_StubMissingProcs(GEN_Procs);\n" : "");
+  }
+}
+
+// Adds every function and define of the registry headers in ArbData to
+// ArbHash. Returns the number of tokens added.
+static
+unsigned int ParseRegistry(char* ArbData, GLArbToken* ArbHash, unsigned long long* TokenCount)
+{
+  //NOTE: Declarations are wrapped in "#ifndef GL_VERSION_4_5" or
+  // "#ifndef GL_ARB_foo" blocks. Functions remember the block they were
+  // declared in, blocks seen again in a later header keep their index.
+  GLString Feature = {};
+  unsigned int FeatureHash = 0;
+  unsigned int FeatureIndex = 0;
+  unsigned int FeatureCount = 0;
+
+  unsigned int ArbTokenCount = 0;
+  unsigned long long RegistryTokens = 0;
+  GLTokenizer Tokenizer;
+  Tokenizer.At = ArbData;
+  while(*Tokenizer.At)
+  {
+    GLArbToken Token = ParseArbToken(&Tokenizer);
+    RegistryTokens++;
+    if (Equal(Token.Value, "#ifndef") && Token.Value.Length == 7)
+    {
+      Token = ParseArbToken(&Tokenizer);
+      FeatureIndex = 0;
+      FeatureHash = 0;
+      if (IsFeatureName(Token.Value))
+      {
+        Feature = Token.Value;
+        FeatureHash = GetStringHash(Feature);
+      }
+    }
+    else if (Equal(Token.Value, "GLAPI"))
+    {
+      char* Start = Token.Value.Chars;
+      char* ReturnType = Tokenizer.At;
+      Token = ParseArbToken(&Tokenizer);
+      if (Equal(Token.Value, "const"))
+      {
+        ParseArbToken(&Tokenizer);
+      }
+      unsigned int ReturnTypeLength = (unsigned int)(Tokenizer.At - ReturnType);
+      ParseArbToken(&Tokenizer);
+      Token = ParseArbToken(&Tokenizer);
+      Token.Hash = GetStringHash(Token.Value);
+      if (!GetToken(ArbHash, Token.Hash))
+      {
+        ArbTokenCount++;
+        GLArbToken* Result = AddToken(ArbHash, Token);
+        Result->FunctionName.Chars = Token.Value.Chars;
+        Result->FunctionName.Length = (unsigned int)(Tokenizer.At - Token.Value.Chars);
+
+        Result->ReturnType.Chars = ReturnType;
+        Result->ReturnType.Length = ReturnTypeLength;
+
+        Result->Parameters.Chars = Tokenizer.At;
+        AdvanceToEndOfLine(&Tokenizer);
+        Result->Parameters.Length = (unsigned int)(Tokenizer.At - Result->Parameters.Chars);
+
+        Result->Line.Chars = Start;
+        Result->Line.Length = (unsigned int)(Tokenizer.At - Start);
+
+        if (FeatureIndex)
+        {
+          Result->Feature = Feature;
+          Result->FeatureIndex = FeatureIndex;
+        }
+      }
+    }
+    else if (StartsWith(Token.Value, "#define"))
+    {
+      char* Start = Token.Value.Chars;
+      Token = ParseArbToken(&Tokenizer);
+      Token.Hash = GetStringHash(Token.Value);
+      GLArbToken* Result = GetToken(ArbHash, Token.Hash);
+      if (!Result)
+      {
+        ArbTokenCount++;
+        Result = AddToken(ArbHash, Token);
+        AdvanceToEndOfLine(&Tokenizer);
+        Result->Line.Chars = Start;
+        Result->Line.Length = (unsigned int)(Tokenizer.At - Start);
+      }
+      if (Result && FeatureHash && Token.Hash == FeatureHash)
+      {
+        if (!Result->FeatureIndex)
+        {
+          Result->FeatureIndex = ++FeatureCount;
         }
+        FeatureIndex = Result->FeatureIndex;
       }
     }
-    free(Data);
-    Success = 1;
+  }
+  *TokenCount = RegistryTokens;
+  return ArbTokenCount;
+}
+
+static inline
+void AddProbeLength(GLTableStats* Stats, unsigned int Slot, unsigned int Hash)
+{
+  unsigned int Probe = ((Slot - Hash) & (TOKEN_HASH_SIZE - 1)) + 1;
+  unsigned int Bucket = Probe <= 4 ? Probe - 1 : Probe <= 8 ? 4 : Probe <= 16 ? 5 : Probe <= 64 ? 6 : 7;
+  Stats->Used++;
+  Stats->TotalProbes += Probe;
+  Stats->Probes[Bucket]++;
+  if (Probe > Stats->MaxProbe)
+  {
+    Stats->MaxProbe = Probe;
+  }
+}
+
+static
+void GetTableStats(GLTableStats* Stats, GLArbToken* TokenHash)
+{
+  for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+  {
+    if (TokenHash[Index].Hash)
+    {
+      AddProbeLength(Stats, Index, TokenHash[Index].Hash);
+    }
+  }
+}
+
+static
+void GetTableStats(GLTableStats* Stats, GLToken* TokenHash)
+{
+  for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+  {
+    if (TokenHash[Index].Hash)
+    {
+      AddProbeLength(Stats, Index, TokenHash[Index].Hash);
+    }
+  }
+}
+
+static const char* ProbeBucketNames[PROBE_BUCKETS] =
+{
+  "1", "2", "3", "4", "5-8", "9-16", "17-64", "65+",
+};
+
+static
+void PrintTableStats(const char* Name, GLTableStats* Stats)
+{
+  printf("  %-14s %5u/%u slots (%.1f%%), mean probe %.2f, max %u\n    probes",
+         Name, Stats->Used, TOKEN_HASH_SIZE, 100.0*Stats->Used/TOKEN_HASH_SIZE,
+         Stats->Used ? (double)Stats->TotalProbes/Stats->Used : 0.0, Stats->MaxProbe);
+  for (int Bucket = 0; Bucket < PROBE_BUCKETS; ++Bucket)
+  {
+    printf(" %s:%u", ProbeBucketNames[Bucket], Stats->Probes[Bucket]);
+  }
+  printf("\n");
+}
+
+static
+void WriteTableStats(FILE* File, const char* Name, GLTableStats* Stats, int Last)
+{
+  fprintf(File, "    \"%s\": {\"slots\": %u, \"used\": %u, \"load_factor\": %.4f, "
+                "\"mean_probe\": %.4f, \"max_probe\": %u, \"probe_histogram\": {",
+          Name, TOKEN_HASH_SIZE, Stats->Used, (double)Stats->Used/TOKEN_HASH_SIZE,
+          Stats->Used ? (double)Stats->TotalProbes/Stats->Used : 0.0, Stats->MaxProbe);
+  for (int Bucket = 0; Bucket < PROBE_BUCKETS; ++Bucket)
+  {
+    fprintf(File, "%s\"%s\": %u", Bucket ? ", " : "", ProbeBucketNames[Bucket], Stats->Probes[Bucket]);
+  }
+  fprintf(File, "}}%s\n", Last ? "" : ",");
+}
+
+// Prints the statistics gathered with -stats and writes them to StatsFile.
+static
+void ReportStats(GLStats* Stats, GLSettings* Settings)
+{
+  unsigned long long PeakMemory = GetPeakMemory();
+  double TotalWall = 0;
+  double TotalCpu = 0;
+  for (int Phase = 0; Phase < PhaseCount; ++Phase)
+  {
+    TotalWall += Stats->Wall[Phase];
+    TotalCpu += Stats->Cpu[Phase];
+  }
+  if (!Settings->Silent)
+  {
+    printf("  %-14s %10s %10s\n", "phase", "wall ms", "cpu ms");
+    for (int Phase = 0; Phase < PhaseCount; ++Phase)
+    {
+      printf("  %-14s %10.3f %10.3f\n", PhaseNames[Phase], Stats->Wall[Phase]*1000.0, Stats->Cpu[Phase]*1000.0);
+    }
+    printf("  %-14s %10.3f %10.3f\n", "total", TotalWall*1000.0, TotalCpu*1000.0);
+    printf("  %u files, %llu bytes read, %llu registry and %llu input tokens scanned\n",
+           Stats->FilesRead, Stats->BytesRead, Stats->RegistryTokens, Stats->InputTokens);
+    PrintTableStats("ArbHash", &Stats->ArbHash);
+    PrintTableStats("FunctionsHash", &Stats->FunctionsHash);
+    PrintTableStats("DefinesHash", &Stats->DefinesHash);
+    printf("  peak RSS %.1f MB\n", (double)PeakMemory/(1024.0*1024.0));
+  }
+
+  FILE* File = fopen(Settings->StatsFile, "w");
+  if (File)
+  {
+    fprintf(File, "{\n  \"phases\": {\n");
+    for (int Phase = 0; Phase < PhaseCount; ++Phase)
+    {
+      fprintf(File, "    \"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f},\n",
+              PhaseNames[Phase], Stats->Wall[Phase]*1000.0, Stats->Cpu[Phase]*1000.0);
+    }
+    fprintf(File, "    \"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}\n  },\n",
+            TotalWall*1000.0, TotalCpu*1000.0);
+    fprintf(File, "  \"files_read\": %u,\n  \"bytes_read\": %llu,\n"
+                  "  \"registry_tokens\": %llu,\n  \"input_tokens\": %llu,\n  \"tables\": {\n",
+            Stats->FilesRead, Stats->BytesRead, Stats->RegistryTokens, Stats->InputTokens);
+    WriteTableStats(File, "ArbHash", &Stats->ArbHash, 0);
+    WriteTableStats(File, "FunctionsHash", &Stats->FunctionsHash, 0);
+    WriteTableStats(File, "DefinesHash", &Stats->DefinesHash, 1);
+    fprintf(File, "  },\n  \"peak_rss_bytes\": %llu\n}\n", PeakMemory);
+    fclose(File);
   }
   else
   {
-    fprintf(stderr, "Couldn't open file %s", Filename);
+    fprintf(stderr, "Couldn't open file %s", Settings->StatsFile);
   }
-  return Success;
 }
 
-
 static
 int GenerateOpenGLHeader(GLSettings* Settings)
 {
-  char* ArbData = ReadMultiFiles(Settings->HeadersStart, Settings->HeadersEnd);
+  GLStats StatsStorage = {};
+  GLStats* Stats = 0;
+  double Start = 0;
+  if (Settings->StatsFile || Settings->TraceFile)
+  {
+    Stats = &StatsStorage;
+    Start = GetWallClock();
+  }
+  if (Settings->TraceFile)
+  {
+    Stats->Trace = fopen(Settings->TraceFile, "w");
+    if (Stats->Trace)
+    {
+      fprintf(Stats->Trace, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+                            "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %llu, "
+                            "\"args\": {\"name\": ", GetProcessIdentifier());
+      WriteJsonString(Stats->Trace, Settings->Output);
+      fprintf(Stats->Trace, "}}");
+      Stats->TraceEvents = 1;
+    }
+    else
+    {
+      fprintf(stderr, "Couldn't open file %s", Settings->TraceFile);
+    }
+  }
+  BeginPhase(Stats);
+  char* ArbData = ReadMultiFiles(Settings->HeadersStart, Settings->HeadersEnd, Stats);
+  EndPhase(Stats, PhaseRegistryRead);
   FILE* Output = fopen(Settings->Output, "w");
   const char* ProcPrefix = "GEN_";
   int Success = -1;
 
+  if (Settings->Lazy && Settings->Async)
+  {
+    fprintf(stderr, YELLOW("WARNING") ": -async has no effect with -lazy\n");
+    Settings->Async = 0;
+  }
+  if (Settings->Dispatch && Settings->Shared)
+  {
+    fprintf(stderr, YELLOW("WARNING") ": -shared has no effect with -dispatch\n");
+    Settings->Shared = 0;
+  }
+
   if (Settings->InputCount <= 0)
   {
     fprintf(stderr, "Invalid input count");
@@ -798,79 +5708,195 @@ int GenerateOpenGLHeader(GLSettings* Settings)
     GLToken* DefinesHash = (GLToken*)calloc(sizeof(GLToken), TOKEN_HASH_SIZE);
     unsigned int FunctionCount = 0;
     unsigned int DefinesCount = 0;
-    unsigned int ArbTokenCount = 0;
 
-    GLTokenizer Tokenizer;
-    Tokenizer.At = ArbData;
-    while(*Tokenizer.At)
+    BeginPhase(Stats);
+    unsigned long long RegistryTokens = 0;
+    unsigned int ArbTokenCount = ParseRegistry(ArbData, ArbHash, &RegistryTokens);
+    if (Stats)
     {
-      GLArbToken Token = ParseArbToken(&Tokenizer);
-      if (Equal(Token.Value, "GLAPI"))
-      {
-        char* Start = Token.Value.Chars;
-        char* ReturnType = Tokenizer.At;
-        Token = ParseArbToken(&Tokenizer);
-        if (Equal(Token.Value, "const"))
-        {
-          ParseArbToken(&Tokenizer);
-        }
-        unsigned int ReturnTypeLength = (unsigned int)(Tokenizer.At - ReturnType);
-        ParseArbToken(&Tokenizer);
-        Token = ParseArbToken(&Tokenizer);
-        Token.Hash = GetStringHash(Token.Value);
-        if (!GetToken(ArbHash, Token.Hash))
-        {
-          ArbTokenCount++;
-          GLArbToken* Result = AddToken(ArbHash, Token);
-          Result->FunctionName.Chars = Token.Value.Chars;
-          Result->FunctionName.Length = (unsigned int)(Tokenizer.At - Token.Value.Chars);
+      Stats->RegistryTokens = RegistryTokens;
+    }
+    EndPhase(Stats, PhaseRegistryParse);
 
-          Result->ReturnType.Chars = ReturnType;
-          Result->ReturnType.Length = ReturnTypeLength;
+    {
+      DefinesCount = 5;
+      AddCustomToken(DefinesHash, "GL_MAJOR_VERSION");
+      AddCustomToken(DefinesHash, "GL_MINOR_VERSION");
+      AddCustomToken(DefinesHash, "GL_VENDOR");
+      AddCustomToken(DefinesHash, "GL_RENDERER");
+      AddCustomToken(DefinesHash, "GL_VERSION");
+    }
+    {
+      FunctionCount = 2;
+      AddCustomToken(FunctionsHash, "glGetIntegerv");
+      AddCustomToken(FunctionsHash, "glGetString");
+    }
 
-          Result->Parameters.Chars = Tokenizer.At;
-          AdvanceToEndOfLine(&Tokenizer);
-          Result->Parameters.Length = (unsigned int)(Tokenizer.At - Result->Parameters.Chars);
+    //NOTE: The location table is filled through glGetUniformLocation and
+    // glGetAttribLocation, which are only declared by the boilerplate.
+    GLLocations* Locations = 0;
+    if (Settings->Locations && !Settings->Boilerplate)
+    {
+      fprintf(stderr, YELLOW("WARNING") ": -locations has no effect with -no-b\n");
+    }
+    else if (Settings->Locations)
+    {
+      Locations = (GLLocations*)calloc(1, sizeof(GLLocations));
+    }
+    for (int Index = 0; Index < Settings->InputCount; ++Index)
+    {
+      ParseFile(Settings->Inputs[Index], ArbHash, FunctionsHash, &FunctionCount,
+                DefinesHash, &DefinesCount, Locations, Stats, Settings);
+    }
 
-          Result->Line.Chars = Start;
-          Result->Line.Length = (unsigned int)(Tokenizer.At - Start);
+    //NOTE: Pooled names are freed with the matching glDelete* function.
+    if (Settings->Pools)
+    {
+      for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+      {
+        GLArbToken* ArbToken = GetToken(ArbHash, FunctionsHash[Index].Hash);
+        if (ArbToken && ArbToken->ReturnType.Length)
+        {
+          ArbToken->PoolDelete = GetPoolDelete(ArbHash, ArbToken);
+          if (ArbToken->PoolDelete)
+          {
+            AddRequiredToken(FunctionsHash, &FunctionCount, ArbToken->PoolDelete->Value);
+          }
         }
       }
-      else if (StartsWith(Token.Value, "#define"))
+    }
+
+    //NOTE: Queued deletions are made early once a fence inserted at the end
+    // of their frame has passed, if the registry has sync objects.
+    if (Settings->DeferDelete)
+    {
+      int Deletes = 0;
+      for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE && !Deletes; ++Index)
+      {
+        GLArbToken* ArbToken = GetToken(ArbHash, FunctionsHash[Index].Hash);
+        Deletes = ArbToken && ArbToken->ReturnType.Length && GetDeleteKind(ArbToken);
+      }
+      const char* Fences[] = {"glFenceSync", "glClientWaitSync", "glDeleteSync",
+                              "GL_SYNC_GPU_COMMANDS_COMPLETE", "GL_ALREADY_SIGNALED",
+                              "GL_CONDITION_SATISFIED"};
+      int HasFences = Deletes;
+      for (unsigned int Index = 0; Index < sizeof(Fences)/sizeof(*Fences); ++Index)
       {
-        char* Start = Token.Value.Chars;
-        Token = ParseArbToken(&Tokenizer);
+        GLString Name = {(char*)Fences[Index], (unsigned int)strlen(Fences[Index])};
+        HasFences = HasFences && GetToken(ArbHash, GetStringHash(Name));
+      }
+      for (unsigned int Index = 0; Index < sizeof(Fences)/sizeof(*Fences) && HasFences; ++Index)
+      {
+        AddRequiredToken(Index < 3 ? FunctionsHash : DefinesHash,
+                         Index < 3 ? &FunctionCount : &DefinesCount, Fences[Index]);
+      }
+    }
+
+    //NOTE: The program cache is only generated for inputs that already use
+    // program binaries, and brings the queries it needs along.
+    if (Settings->ProgramCache)
+    {
+      const char* Binaries[] = {"glProgramBinary", "glGetProgramBinary", "glGetProgramiv",
+                                "GL_LINK_STATUS", "GL_PROGRAM_BINARY_LENGTH"};
+      int Used = 0;
+      int Available = Settings->Boilerplate;
+      for (unsigned int Index = 0; Index < sizeof(Binaries)/sizeof(*Binaries); ++Index)
+      {
+        GLToken Token;
+        Token.Value.Chars = (char*)Binaries[Index];
+        Token.Value.Length = (unsigned int)strlen(Binaries[Index]);
         Token.Hash = GetStringHash(Token.Value);
-        if (!GetToken(ArbHash, Token.Hash))
+        Used = Used || (Index < 2 && Contains(FunctionsHash, Token));
+        Available = Available && GetToken(ArbHash, Token.Hash);
+      }
+      Settings->ProgramCache = Used && Available;
+      if (!Settings->ProgramCache)
+      {
+        fprintf(stderr, YELLOW("WARNING") ": -programcache has no effect without "
+                        "glProgramBinary or glGetProgramBinary in the inputs\n");
+      }
+      for (unsigned int Index = 0; Index < sizeof(Binaries)/sizeof(*Binaries) && Settings->ProgramCache; ++Index)
+      {
+        AddRequiredToken(Index < 3 ? FunctionsHash : DefinesHash,
+                         Index < 3 ? &FunctionCount : &DefinesCount, Binaries[Index]);
+      }
+    }
+
+    //NOTE: Extensions that own a used function need a bit to decide
+    // whether the function gets resolved.
+    if (Settings->Features && Settings->Boilerplate)
+    {
+      for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
+      {
+        GLArbToken* ArbToken = GetToken(ArbHash, FunctionsHash[Index].Hash);
+        if (ArbToken && ArbToken->FeatureIndex && IsExtensionName(ArbToken->Feature))
         {
-          ArbTokenCount++;
-          GLArbToken* Result = AddToken(ArbHash, Token);
-          AdvanceToEndOfLine(&Tokenizer);
-          Result->Line.Chars = Start;
-          Result->Line.Length = (unsigned int)(Tokenizer.At - Start);
+          AddRequiredToken(DefinesHash, &DefinesCount, ArbToken->Feature);
         }
       }
     }
 
+    //NOTE: Extension names used in the inputs get a bit in the extension
+    // bitset, which OpenGLInit fills from the extension strings.
+    unsigned int ExtensionCount = 0;
+    for (unsigned int Index = 0; Index < TOKEN_HASH_SIZE; ++Index)
     {
-      DefinesCount = 2;
-      AddCustomToken(DefinesHash, "GL_MAJOR_VERSION");
-      AddCustomToken(DefinesHash, "GL_MINOR_VERSION");
+      GLArbToken* ArbToken = GetToken(ArbHash, DefinesHash[Index].Hash);
+      if (ArbToken && IsExtensionName(ArbToken->Value))
+      {
+        ExtensionCount++;
+      }
     }
+    if (ExtensionCount)
     {
-      FunctionCount = 1;
-      AddCustomToken(FunctionsHash, "glGetIntegerv");
+      AddRequiredToken(DefinesHash, &DefinesCount, "GL_NUM_EXTENSIONS");
+      AddRequiredToken(DefinesHash, &DefinesCount, "GL_EXTENSIONS");
+      AddRequiredToken(FunctionsHash, &FunctionCount, "glGetStringi");
     }
 
-    for (int Index = 0; Index < Settings->InputCount; ++Index)
+    if (Stats)
     {
-      ParseFile(Settings->Inputs[Index], ArbHash, FunctionsHash, &FunctionCount,
-                DefinesHash, &DefinesCount, Settings);
+      GetTableStats(&Stats->ArbHash, ArbHash);
+      GetTableStats(&Stats->FunctionsHash, FunctionsHash);
+      GetTableStats(&Stats->DefinesHash, DefinesHash);
     }
 
+    BeginPhase(Stats);
     qsort(FunctionsHash, TOKEN_HASH_SIZE, sizeof(GLToken), TokenComparer);
     qsort(DefinesHash, TOKEN_HASH_SIZE, sizeof(GLToken), TokenComparer);
 
+    //NOTE: Functions found in the registry, in the order they are emitted. The
+    // position in this array is the function ID used by the generated loader.
+    GLArbToken** Functions = (GLArbToken**)malloc(sizeof(GLArbToken*) * (FunctionCount + 1));
+    unsigned int UsedFunctionCount = 0;
+    for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+    {
+      GLToken* Token = FunctionsHash + Index;
+      GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
+      if (ArbToken)
+      {
+        Functions[UsedFunctionCount++] = ArbToken;
+      }
+    }
+    if (Settings->Features && Settings->Boilerplate)
+    {
+      //NOTE: Functions of the same feature get consecutive IDs so each
+      // feature resolves a single range.
+      qsort(Functions, UsedFunctionCount, sizeof(GLArbToken*), FeatureComparer);
+    }
+    GLArbToken** Extensions = (GLArbToken**)malloc(sizeof(GLArbToken*) * (ExtensionCount + 1));
+    ExtensionCount = 0;
+    for (unsigned int Index = 0; Index < DefinesCount; ++Index)
+    {
+      GLArbToken* ArbToken = GetToken(ArbHash, DefinesHash[Index].Hash);
+      if (ArbToken && IsExtensionName(ArbToken->Value))
+      {
+        Extensions[ExtensionCount++] = ArbToken;
+      }
+    }
+    EndPhase(Stats, PhaseSort);
+
+    BeginPhase(Stats);
     {
       const char* Prefix = "";
       if (Settings->Prefix)
@@ -881,6 +5907,7 @@ int GenerateOpenGLHeader(GLSettings* Settings)
       const char* Generated =
         "#ifndef INCLUDE_OPENGL_GENERATED_H\n"
         "#define INCLUDE_OPENGL_GENERATED_H\n\n"
+        "#include <stddef.h> // ptrdiff_t\n\n"
         "// NOTE: This file is generated automatically. Do not edit.\n"
         "// @GENERATED: %llu\n\n";
       fprintf(Output, Generated, Settings->WriteTimestamp);
@@ -902,10 +5929,33 @@ int GenerateOpenGLHeader(GLSettings* Settings)
         "//       return 0;\n"
         "//    }\n"
         "//\n"
-        "static void %sOpenGLInit(%sOpenGLVersion* Version);\n\n\n";
+        "static inline void %sOpenGLInit(%sOpenGLVersion* Version);\n"
+        "// Returns non zero once OpenGLInit completed on any thread and until\n"
+        "// OpenGLShutdown. Safe to call from any thread.\n"
+        "static inline int %sOpenGLIsInitialized();\n"
+        "// Forgets all function pointers and unloads OpenGL.\n"
+        "static inline void %sOpenGLShutdown();\n\n\n";
       if (Settings->Boilerplate)
       {
-        fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+        fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+        if (Settings->Async)
+        {
+          Generated =
+            "// Asynchronous alternative to OpenGLInit. Start resolving as early as\n"
+            "// possible and wait before the first OpenGL call.\n"
+            "// Example:\n"
+            "//\n"
+            "//    %sOpenGLInitAsync();\n"
+            "//    CreateWindowAndContext();\n"
+            "//    LoadAssets();\n"
+            "//    %sOpenGLVersion Version;\n"
+            "//    %sOpenGLWaitReady(&Version);\n"
+            "//\n"
+            "static inline void %sOpenGLInitAsync();\n"
+            "static inline int %sOpenGLIsReady();\n"
+            "static inline void %sOpenGLWaitReady(%sOpenGLVersion* Version);\n\n\n";
+          fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+        }
       }
 
       Generated =
@@ -942,6 +5992,41 @@ int GenerateOpenGLHeader(GLSettings* Settings)
 
       fprintf(Output, "%s", Generated);
 
+      //NOTE: Types the registry gets from khrplatform.h are only written when
+      // a used function needs them.
+      const char* Types[][2] =
+      {
+        {"GLsync", "typedef struct __GLsync *GLsync;\n"},
+        {"GLint64", "#include <stdint.h>\ntypedef int64_t GLint64;\n"},
+        {"GLuint64", "#include <stdint.h>\ntypedef uint64_t GLuint64;\n"},
+        {"GLint64EXT", "#include <stdint.h>\ntypedef int64_t GLint64EXT;\n"},
+        {"GLuint64EXT", "#include <stdint.h>\ntypedef uint64_t GLuint64EXT;\n"},
+        {"GLfixed", "#include <stdint.h>\ntypedef int32_t GLfixed;\n"},
+        {"GLhalfNV", "typedef unsigned short GLhalfNV;\n"},
+        {"GLhalfARB", "typedef unsigned short GLhalfARB;\n"},
+        {"GLcharARB", "typedef char GLcharARB;\n"},
+        {"GLhandleARB", "#ifdef __APPLE__\ntypedef void *GLhandleARB;\n#else\ntypedef unsigned int GLhandleARB;\n#endif\n"},
+        {"GLintptrARB", "typedef ptrdiff_t GLintptrARB;\n"},
+        {"GLsizeiptrARB", "typedef ptrdiff_t GLsizeiptrARB;\n"},
+        {"GLvdpauSurfaceNV", "typedef GLintptr GLvdpauSurfaceNV;\n"},
+        {"GLeglImageOES", "typedef void *GLeglImageOES;\n"},
+        {"GLeglClientBufferEXT", "typedef void *GLeglClientBufferEXT;\n"},
+        {"GLDEBUGPROCARB", "typedef void (APIENTRY *GLDEBUGPROCARB)(GLenum source,GLenum type,GLuint id,GLenum severity,GLsizei length,const GLchar *message,const void *userParam);\n"},
+        {"GLDEBUGPROCAMD", "typedef void (APIENTRY *GLDEBUGPROCAMD)(GLuint id,GLenum category,GLenum severity,GLsizei length,const GLchar *message,void *userParam);\n"},
+        {"GLVULKANPROCNV", "typedef void (APIENTRY *GLVULKANPROCNV)(void);\n"},
+      };
+      for (unsigned int Type = 0; Type < sizeof(Types)/sizeof(*Types); ++Type)
+      {
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+        {
+          if (ContainsText(Functions[Index]->Line, Types[Type][0]))
+          {
+            fprintf(Output, "%s", Types[Type][1]);
+            break;
+          }
+        }
+      }
+
 
       for (unsigned int Index = 0; Index < DefinesCount; ++Index)
       {
@@ -959,72 +6044,253 @@ int GenerateOpenGLHeader(GLSettings* Settings)
         "typedef void (APIENTRY *GLDEBUGPROC)(GLenum source,GLenum type,GLuint id,GLenum severity,GLsizei length,const GLchar *message,const void *userParam);\n";
       fprintf(Output, "%s", Generated);
 
-      for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+      for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
       {
-        GLToken* Token = FunctionsHash + Index;
-        GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
-        if (ArbToken)
+        GLArbToken* ArbToken = Functions[Index];
+        char Name[512];
+        UpperCase(Name, ArbToken->FunctionName);
+        char Buffer[512];
+        int Length = sprintf(Buffer, "typedef %" PRI_STR " (APIENTRYP PFN%sPROC) %" PRI_STR "\n",
+                             ArbToken->ReturnType.Length, ArbToken->ReturnType.Chars,
+                             Name,
+                             ArbToken->Parameters.Length, ArbToken->Parameters.Chars);
+
+        fwrite(Buffer, (size_t)Length, 1, Output);
+      }
+      if (Settings->Boilerplate)
+      {
+        fwrite(Spacer, strlen(Spacer), 1, Output);
+        fprintf(Output, "typedef void (*%sOpenGLProc)(void);\n\n", Prefix);
+
+        //NOTE: Function IDs index into the pointer table
+        fprintf(Output, "enum\n{\n");
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+        {
+          GLArbToken* ArbToken = Functions[Index];
+          fprintf(Output, "  GEN_ID_%" PRI_STR ",\n",
+                  ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
+        }
+        fprintf(Output, "  GEN_PROC_COUNT\n};\n\n");
+        if (Settings->Dispatch)
+        {
+          //NOTE: Calls go through the dispatch table selected for the calling
+          // thread, which costs a single TLS load.
+          WriteThreadLocal(Output);
+          Generated =
+            "typedef struct %sOpenGLDispatch\n"
+            "{\n"
+            "  %sOpenGLProc Procs[GEN_PROC_COUNT];\n"
+            "} %sOpenGLDispatch;\n"
+            "// Resolves all functions into Dispatch for the context current on the\n"
+            "// calling thread. The table becomes active with OpenGLMakeDispatchCurrent.\n"
+            "// Example:\n"
+            "//\n"
+            "//    static %sOpenGLDispatch HeadlessDispatch;\n"
+            "//    MakeContextCurrent(HeadlessContext);\n"
+            "//    %sOpenGLInitDispatch(&HeadlessDispatch);\n"
+            "//    %sOpenGLMakeDispatchCurrent(&HeadlessDispatch);\n"
+            "//\n"
+            "static inline void %sOpenGLInitDispatch(%sOpenGLDispatch* Dispatch);\n"
+            "// Selects the table used by OpenGL calls on the calling thread. Passing\n"
+            "// null selects the table filled by OpenGLInit.\n"
+            "static inline void %sOpenGLMakeDispatchCurrent(%sOpenGLDispatch* Dispatch);\n"
+            "static inline %sOpenGLDispatch* %sOpenGLGetCurrentDispatch();\n\n"
+            "static %sOpenGLDispatch GEN_Dispatch;\n"
+            "static GEN_THREAD_LOCAL %sOpenGLDispatch* GEN_CurrentDispatch = &GEN_Dispatch;\n"
+            "#define GEN_Procs GEN_Dispatch.Procs\n"
+            "#define GEN_PROCS GEN_CurrentDispatch->Procs\n\n";
+          fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix,
+                  Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+        }
+        else if (Settings->Shared)
+        {
+          //NOTE: Calls go through a pointer so a module can use the table of
+          // its host, which costs one extra load per call.
+          Generated =
+            "typedef struct %sOpenGLSharedTable\n"
+            "{\n"
+            "  unsigned int NamesHash;\n"
+            "  int Count;\n"
+            "  const char* Names;\n"
+            "  %sOpenGLProc* Procs;\n"
+            "} %sOpenGLSharedTable;\n"
+            "// Lets code that is reloaded at runtime use the functions resolved by\n"
+            "// its host instead of loading OpenGL again.\n"
+            "// Example:\n"
+            "//\n"
+            "//    // Host, once\n"
+            "//    %sOpenGLInit(&Version);\n"
+            "//    GameMemory->OpenGL = %sOpenGLGetSharedTable();\n"
+            "//\n"
+            "//    // Module, after every reload\n"
+            "//    %sOpenGLBindShared(GameMemory->OpenGL);\n"
+            "//\n"
+            "static inline %sOpenGLSharedTable* %sOpenGLGetSharedTable();\n"
+            "static inline int %sOpenGLBindShared(%sOpenGLSharedTable* Table);\n\n"
+            "static %sOpenGLProc GEN_Procs[GEN_PROC_COUNT];\n"
+            "static %sOpenGLProc* GEN_BoundProcs = GEN_Procs;\n"
+            "#define GEN_PROCS GEN_BoundProcs\n\n";
+          fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix,
+                  Prefix, Prefix, Prefix, Prefix, Prefix);
+        }
+        else
+        {
+          fprintf(Output, "static %sOpenGLProc GEN_Procs[GEN_PROC_COUNT];\n", Prefix);
+          fprintf(Output, "#define GEN_PROCS GEN_Procs\n\n");
+        }
+
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
         {
+          GLArbToken* ArbToken = Functions[Index];
           char Name[512];
           UpperCase(Name, ArbToken->FunctionName);
           char Buffer[512];
-          int Length = sprintf(Buffer, "typedef %" PRI_STR " (APIENTRYP PFN%sPROC) %" PRI_STR "\n",
-                               ArbToken->ReturnType.Length, ArbToken->ReturnType.Chars,
+          int Length = sprintf(Buffer, "#define %s%" PRI_STR " ((PFN%sPROC)GEN_PROCS[GEN_ID_%" PRI_STR "])\n",
+                               ProcPrefix,
+                               ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
                                Name,
-                               ArbToken->Parameters.Length, ArbToken->Parameters.Chars);
+                               ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
 
           fwrite(Buffer, (size_t)Length, 1, Output);
         }
-      }
-      if (Settings->Boilerplate)
-      {
+
         fwrite(Spacer, strlen(Spacer), 1, Output);
-        for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+        if (Settings->Wrappers)
+        {
+          Generated =
+            "// Define GEN_WRAPPER_ATTRIBUTES before including this file to decorate\n"
+            "// every wrapper, e.g. with __attribute__((hot)).\n"
+            "#ifndef GEN_WRAPPER_ATTRIBUTES\n"
+            "#define GEN_WRAPPER_ATTRIBUTES\n"
+            "#endif\n\n";
+          fprintf(Output, "%s", Generated);
+          if (Settings->Instrument)
+          {
+            WriteInstrumentation(Output);
+          }
+          if (Settings->Capture || Settings->Commands)
+          {
+            WriteEncoding(Output);
+            if (Settings->Capture)
+            {
+              WriteCapture(Output);
+            }
+            if (Settings->Commands)
+            {
+              WriteCommands(Output, Prefix);
+            }
+            for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+            {
+              if (Settings->Capture || IsDeferrable(Functions[Index]))
+              {
+                WriteEncoder(Output, Functions[Index]);
+              }
+            }
+            fprintf(Output, "\n");
+          }
+          unsigned int StateGroups = 0;
+          if (Settings->StateCache)
+          {
+            StateGroups = GetStateGroups(Functions, UsedFunctionCount);
+            StateGroups |= GetStateQueries(DefinesHash, DefinesCount, StateGroups);
+            WriteStateCache(Output, Prefix, StateGroups, DefinesHash, DefinesCount);
+          }
+          if (Settings->Pools)
+          {
+            WriteNamePools(Output, Prefix, Functions, UsedFunctionCount);
+          }
+          if (Settings->DeferDelete)
+          {
+            WriteDeleteQueue(Output, Prefix, Functions, UsedFunctionCount, Settings->StateCache);
+          }
+          for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+          {
+            WriteWrapper(Output, Settings, Functions[Index], StateGroups);
+          }
+          if (Settings->Commands)
+          {
+            WriteCommandExecution(Output, Prefix, Functions, UsedFunctionCount);
+          }
+        }
+        else
         {
-          GLToken* Token = FunctionsHash + Index;
-          GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
-          if (ArbToken)
+          for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
           {
+            GLArbToken* ArbToken = Functions[Index];
             char Buffer[512];
             int Length = sprintf(Buffer, "#define %" PRI_STR " %s%" PRI_STR "\n",
                                  ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
                                  ProcPrefix,
                                  ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
 
-
             fwrite(Buffer, (size_t)Length, 1, Output);
           }
         }
 
-        fwrite(Spacer, strlen(Spacer), 1, Output);
-        for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+        //NOTE: All names live in a single relocation-free blob and are looked
+        // up through an offset table, so the loader needs neither one string
+        // pointer nor one statement per function.
+        unsigned int NamesSize = 0;
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+        {
+          NamesSize += Functions[Index]->FunctionName.Length + 1;
+        }
+        const char* OffsetType = NamesSize > 0xFFFF ? "unsigned int" : "unsigned short";
+        fprintf(Output, "\n\nstatic const char GEN_ProcNames[] =\n");
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+        {
+          GLArbToken* ArbToken = Functions[Index];
+          fprintf(Output, "  \"%" PRI_STR "\\0\"%s\n",
+                  ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+                  Index + 1 == UsedFunctionCount ? ";" : "");
+        }
+        //NOTE: Without a single function in the registry the tables still
+        // need an initializer and a non zero size.
+        if (!UsedFunctionCount)
         {
-          GLToken* Token = FunctionsHash + Index;
-          GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
-          if (ArbToken)
+          fprintf(Output, "  \"\";\n");
+        }
+        fprintf(Output, "static const %s GEN_ProcNameOffsets[%s] =\n{%s", OffsetType,
+                UsedFunctionCount ? "GEN_PROC_COUNT" : "1", UsedFunctionCount ? "" : "\n  0,");
+        unsigned int Offset = 0;
+        for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+        {
+          fprintf(Output, "%s%u,", (Index % 12) == 0 ? "\n  " : " ", Offset);
+          Offset += Functions[Index]->FunctionName.Length + 1;
+        }
+        fprintf(Output, "\n};\n");
+        if (Settings->Shared)
+        {
+          //NOTE: Modules generated from the same inputs have the same names in
+          // the same order and can use the table of the host as is.
+          unsigned int NamesHash = 2166136261u;
+          for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
           {
-            char Name[512];
-            UpperCase(Name, ArbToken->FunctionName);
-            char Buffer[512];
-            int Length = sprintf(Buffer, "PFN%sPROC %s%" PRI_STR ";\n", Name, ProcPrefix,
-                                 ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
-
-            fwrite(Buffer, (size_t)Length, 1, Output);
+            GLString Name = Functions[Index]->FunctionName;
+            for (unsigned int Char = 0; Char <= Name.Length; ++Char)
+            {
+              NamesHash = (NamesHash ^ (Char < Name.Length ? (unsigned char)Name.Chars[Char] : 0u))*16777619u;
+            }
           }
+          fprintf(Output, "#define GEN_PROC_NAMES_HASH 0x%08Xu\n", NamesHash);
         }
 
+        //NOTE: Every OpenGLInit, OpenGLInitAsync and OpenGLInitDispatch takes
+        // a reference to the library and every OpenGLShutdown drops one.
         Generated =
-          "\n\n"
-          "typedef void (*%sOpenGLProc)(void);\n\n"
+          "\n"
+          "static int GEN_OpenGLReferences;\n"
           "#ifdef _WIN32\n"
           "static HMODULE %sOpenGLHandle;\n"
           "static void %sLoadOpenGL()\n"
           "{\n"
-          "  %sOpenGLHandle = LoadLibraryA(\"opengl32.dll\");\n"
+          "  if (GEN_OpenGLReferences++ == 0)\n"
+          "    %sOpenGLHandle = LoadLibraryA(\"opengl32.dll\");\n"
           "}\n"
           "static void %sUnloadOpenGL()\n"
           "{\n"
-          "  FreeLibrary(%sOpenGLHandle);\n"
+          "  if (GEN_OpenGLReferences > 0 && --GEN_OpenGLReferences == 0)\n"
+          "    FreeLibrary(%sOpenGLHandle);\n"
           "}\n"
           "static %sOpenGLProc %sOpenGLGetProc(const char *proc)\n"
           "{\n"
@@ -1041,15 +6307,21 @@ int GenerateOpenGLHeader(GLSettings* Settings)
           "\n"
           "static void %sLoadOpenGL()\n"
           "{\n"
-          "  GEN_BundleURL = CFURLCreateWithFileSystemPath(kCFAllocatorDefault,\n"
-          "    CFSTR(\"/System/Library/Frameworks/OpenGL.framework\"),\n"
-          "    kCFURLPOSIXPathStyle, 1);\n"
-          "  GEN_Bundle = CFBundleCreate(kCFAllocatorDefault, GEN_BundleURL);\n"
+          "  if (GEN_OpenGLReferences++ == 0)\n"
+          "  {\n"
+          "    GEN_BundleURL = CFURLCreateWithFileSystemPath(kCFAllocatorDefault,\n"
+          "      CFSTR(\"/System/Library/Frameworks/OpenGL.framework\"),\n"
+          "      kCFURLPOSIXPathStyle, 1);\n"
+          "    GEN_Bundle = CFBundleCreate(kCFAllocatorDefault, GEN_BundleURL);\n"
+          "  }\n"
           "}\n"
           "static void %sUnloadOpenGL()\n"
           "{\n"
-          "  CFRelease(GEN_Bundle);\n"
-          "  CFRelease(GEN_BundleURL);\n"
+          "  if (GEN_OpenGLReferences > 0 && --GEN_OpenGLReferences == 0)\n"
+          "  {\n"
+          "    CFRelease(GEN_Bundle);\n"
+          "    CFRelease(GEN_BundleURL);\n"
+          "  }\n"
           "}\n"
           "static %sOpenGLProc %sOpenGLGetProc(const char *proc)\n"
           "{\n"
@@ -1068,12 +6340,16 @@ int GenerateOpenGLHeader(GLSettings* Settings)
           "static PFNGLXGETPROCADDRESSPROC glx_get_proc_address;\n"
           "static void %sLoadOpenGL()\n"
           "{\n"
-          "  %sOpenGLHandle = dlopen(\"libGL.so.1\", RTLD_LAZY | RTLD_GLOBAL);\n"
-          "  glx_get_proc_address = (PFNGLXGETPROCADDRESSPROC) dlsym(%sOpenGLHandle, \"glXGetProcAddressARB\");\n"
+          "  if (GEN_OpenGLReferences++ == 0)\n"
+          "  {\n"
+          "    %sOpenGLHandle = dlopen(\"libGL.so.1\", RTLD_LAZY | RTLD_GLOBAL);\n"
+          "    glx_get_proc_address = (PFNGLXGETPROCADDRESSPROC) dlsym(%sOpenGLHandle, \"glXGetProcAddressARB\");\n"
+          "  }\n"
           "}\n"
           "static void %sUnloadOpenGL()\n"
           "{\n"
-          "  dlclose(%sOpenGLHandle);\n"
+          "  if (GEN_OpenGLReferences > 0 && --GEN_OpenGLReferences == 0)\n"
+          "    dlclose(%sOpenGLHandle);\n"
           "}\n"
           "static %sOpenGLProc %sOpenGLGetProc(const char *proc)\n"
           "{\n"
@@ -1096,42 +6372,430 @@ int GenerateOpenGLHeader(GLSettings* Settings)
                 Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix,
                 Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix,
                 Prefix, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
-        Generated =
-          "\n\nvoid %sOpenGLInit(%sOpenGLVersion* Version)\n"
-          "{\n"
-          "  %sLoadOpenGL();\n\n";
-        fprintf(Output, Generated, Prefix, Prefix, Prefix);
-        for (unsigned int Index = 0; Index < FunctionCount; ++Index)
+        if (Settings->Fallbacks)
+        {
+          WriteFallbacks(Output, Prefix, Functions, UsedFunctionCount, Settings->Lazy);
+        }
+        if (!Settings->Lazy)
+        {
+          Generated =
+            "static inline void GEN_ResolveProcs(%sOpenGLProc* Procs)\n"
+            "{\n"
+            "  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+            "  {\n"
+            "    Procs[Index] = %sOpenGLGetProc(GEN_ProcNames + GEN_ProcNameOffsets[Index]);\n"
+            "  }\n"
+            "%s"
+            "}\n";
+          fprintf(Output, Generated, Prefix, Prefix,
+                  Settings->Fallbacks ? "  GEN_StubMissingProcs(Procs);\n" : "");
+        }
+        if (Settings->Lazy)
         {
-          GLToken* Token = FunctionsHash + Index;
-          GLArbToken* ArbToken = GetToken(ArbHash, Token->Hash);
-          if (ArbToken)
+          //NOTE: Every pointer starts out at a stub that resolves the real
+          // address on first call, patches the table and forwards the call.
+          fprintf(Output, "\n");
+          for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
           {
-            char Name[512];
-            UpperCase(Name, ArbToken->FunctionName);
-            char Buffer[512];
-            int Length = sprintf(Buffer, "  %s%" PRI_STR " = (PFN%sPROC)%sOpenGLGetProc(\"%" PRI_STR "\");\n",
-                                 ProcPrefix,
-                                 ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
-                                 Name, Prefix, ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
-
-            fwrite(Buffer, (size_t)Length, 1, Output);
+            GLArbToken* ArbToken = Functions[Index];
+            GLString Parameters = GetParameterList(ArbToken->Parameters);
+            char Arguments[1024];
+            GetArgumentNames(ArbToken->Parameters, Arguments);
+            fprintf(Output,
+                    "static %" PRI_STR " APIENTRY GEN_Lazy_%" PRI_STR "%" PRI_STR "\n"
+                    "{\n"
+                    "  GEN_PROCS[GEN_ID_%" PRI_STR "] = %sOpenGLGetProc(GEN_ProcNames + GEN_ProcNameOffsets[GEN_ID_%" PRI_STR "]);\n"
+                    "%s%" PRI_STR "%s"
+                    "  %s%s%" PRI_STR "(%s);\n"
+                    "}\n",
+                    TrimString(ArbToken->ReturnType).Length, TrimString(ArbToken->ReturnType).Chars,
+                    ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+                    Parameters.Length, Parameters.Chars,
+                    ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+                    Prefix,
+                    ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+                    Settings->Fallbacks ? "  GEN_StubMissingProc(GEN_PROCS, GEN_ID_" : "",
+                    Settings->Fallbacks ? ArbToken->FunctionName.Length : 0, ArbToken->FunctionName.Chars,
+                    Settings->Fallbacks ? ");\n" : "",
+                    ReturnsVoid(ArbToken) ? "" : "return ", ProcPrefix,
+                    ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars,
+                    Arguments);
+          }
+          fprintf(Output, "\nstatic const %sOpenGLProc GEN_LazyProcs[GEN_PROC_COUNT] =\n{\n", Prefix);
+          for (unsigned int Index = 0; Index < UsedFunctionCount; ++Index)
+          {
+            GLArbToken* ArbToken = Functions[Index];
+            fprintf(Output, "  (%sOpenGLProc)GEN_Lazy_%" PRI_STR ",\n", Prefix,
+                    ArbToken->FunctionName.Length, ArbToken->FunctionName.Chars);
+          }
+          fprintf(Output, "};\n");
+          Generated =
+            "\n"
+            "static inline void GEN_ResolveProcs(%sOpenGLProc* Procs)\n"
+            "{\n"
+            "  for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+            "  {\n"
+            "    Procs[Index] = GEN_LazyProcs[Index];\n"
+            "  }\n"
+            "}\n";
+          fprintf(Output, Generated, Prefix);
+        }
+        if (ExtensionCount)
+        {
+          WriteExtensions(Output, Prefix, Extensions, ExtensionCount);
+        }
+        unsigned int FeatureCount = 0;
+        if (Settings->Features)
+        {
+          FeatureCount = GetFeatureCount(Functions, UsedFunctionCount);
+        }
+        if (FeatureCount)
+        {
+          WriteFeatures(Output, Prefix, Functions, UsedFunctionCount, ExtensionCount,
+                        Settings->Lazy, Settings->Fallbacks);
+        }
+        char ClearMasks[1024] = "";
+        if (FeatureCount)
+        {
+          sprintf(ClearMasks,
+                  "    for (int Index = 0; Index < (%sOpenGLFeatureCount + 31)/32; ++Index)\n"
+                  "    {\n"
+                  "      GEN_Features[Index] = 0;\n"
+                  "    }\n", Prefix);
+        }
+        if (Settings->Fallbacks)
+        {
+          strcat(ClearMasks,
+                 "    for (int Index = 0; Index < (GEN_PROC_COUNT + 31)/32; ++Index)\n"
+                 "    {\n"
+                 "      GEN_Missing[Index] = 0;\n"
+                 "      GEN_MissingReported[Index] = 0;\n"
+                 "    }\n");
+        }
+        //NOTE: OpenGLInit is called with a new context current, so what the
+        // calling thread selected for its context still holds names of the
+        // previous one.
+        char InitResets[256] = "";
+        for (unsigned int Index = 0; Settings->Pools && Index < UsedFunctionCount; ++Index)
+        {
+          if (Functions[Index]->PoolDelete)
+          {
+            //NOTE: Names left in the pools belong to a context that is gone.
+            strcat(ClearMasks,
+                   "    GEN_ForgetNamePools(&GEN_DefaultNamePools);\n"
+                   "    GEN_ForgetNamePools(GEN_NamePools);\n");
+            strcat(InitResets, "  GEN_ForgetNamePools(GEN_NamePools);\n");
+            break;
           }
         }
+        if (Settings->DeferDelete)
+        {
+          //NOTE: Queued names and fences belong to a context that is gone.
+          strcat(ClearMasks,
+                 "    GEN_ForgetDeletes(&GEN_DefaultDeleteQueue);\n"
+                 "    GEN_ForgetDeletes(GEN_DeleteQueue);\n");
+          strcat(InitResets, "  GEN_ForgetDeletes(GEN_DeleteQueue);\n");
+        }
+        //NOTE: With features the extensions are loaded as part of resolving.
+        const char* LoadExtensions = "";
+        if (FeatureCount)
+        {
+          LoadExtensions = Settings->Lazy ? "GEN_LoadFeatures();\n" : "";
+        }
+        else if (ExtensionCount)
+        {
+          LoadExtensions = "GEN_LoadExtensions();\n";
+        }
+        //NOTE: Everything that loads, resolves or unloads runs under a single
+        // lock, so threads that initialize at the same time resolve once and
+        // OpenGLIsInitialized only sees a complete table.
+        fprintf(Output, "\n");
+        WriteAtomics(Output);
         Generated =
-          "\n  %sUnloadOpenGL();\n"
+          "static volatile long GEN_InitLock;\n"
+          "static volatile long GEN_Published;\n"
+          "static int GEN_Initialized;\n"
+          "static unsigned long long GEN_DriverIdentity;\n"
+          "\n"
+          "static void GEN_LockInit()\n"
+          "{\n"
+          "  while (!GEN_AtomicCompareExchange(&GEN_InitLock, 0, 1))\n"
+          "  {\n"
+          "    GEN_Yield();\n"
+          "  }\n"
+          "}\n"
+          "\n"
+          "static void GEN_UnlockInit()\n"
+          "{\n"
+          "  GEN_AtomicStoreRelease(&GEN_InitLock, 0);\n"
+          "}\n"
+          "\n"
+          "int %sOpenGLIsInitialized()\n"
+          "{\n"
+          "  return GEN_AtomicLoadAcquire(&GEN_Published) != 0;\n"
+          "}\n"
+          "\n"
+          "// Hashes GL_VENDOR, GL_RENDERER and GL_VERSION of the current context.\n"
+          "// Returns zero if there is no context to ask.\n"
+          "static unsigned long long GEN_GetDriverIdentity()\n"
+          "{\n"
+          "  unsigned long long Result = 0;\n"
+          "  if (GEN_glGetString)\n"
+          "  {\n"
+          "    GLenum Names[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};\n"
+          "    Result = 14695981039346656037ull;\n"
+          "    for (int Index = 0; Index < 3 && Result; ++Index)\n"
+          "    {\n"
+          "      const GLubyte* String = GEN_glGetString(Names[Index]);\n"
+          "      if (!String)\n"
+          "      {\n"
+          "        Result = 0;\n"
+          "        break;\n"
+          "      }\n"
+          "      do\n"
+          "      {\n"
+          "        Result = (Result ^ *String)*1099511628211ull;\n"
+          "      } while (*String++);\n"
+          "    }\n"
+          "  }\n"
+          "  return Result;\n"
+          "}\n"
+          "\n"
+          "static void GEN_AcquireOpenGL()\n"
+          "{\n"
+          "  %sLoadOpenGL();\n"
+          "  GEN_Initialized = 1;\n"
+          "}\n"
+          "\n"
+          "// Loads OpenGL and resolves the function pointers with the context current.\n"
+          "// Calling it again, e.g. after recreating the context, only resolves again if\n"
+          "// the vendor, renderer or version changed. Every call takes a reference that\n"
+          "// OpenGLShutdown drops.\n"
+          "void %sOpenGLInit(%sOpenGLVersion* Version)\n"
+          "{\n"
+          "  GEN_LockInit();\n"
+          "  GEN_AcquireOpenGL();\n"
+          "  unsigned long long Identity = GEN_GetDriverIdentity();\n"
+          "  if (!Identity || Identity != GEN_DriverIdentity)\n"
+          "  {\n"
+          "    %s\n"
+          "    GEN_DriverIdentity = GEN_GetDriverIdentity();\n"
+          "%s%s"
+          "  }\n"
+          "%s"
+          "  GEN_AtomicStoreRelease(&GEN_Published, 1);\n"
+          "  GEN_UnlockInit();\n"
           "\n"
           "  Version->Major = 0;\n"
           "  Version->Minor = 0;\n"
-          "  if (glGetIntegerv)\n"
+          "  if (GEN_glGetIntegerv)\n"
           "  {\n"
           "    glGetIntegerv(GL_MAJOR_VERSION, &Version->Major);\n"
           "    glGetIntegerv(GL_MINOR_VERSION, &Version->Minor);\n"
           "  }\n"
           "}\n\n"
-          "#endif // INCLUDE_OPENGL_GENERATED_H\n";
-        fprintf(Output, Generated, Prefix);
+          "// Drops the reference taken by an OpenGLInit. The last one forgets all\n"
+          "// function pointers and unloads OpenGL.\n"
+          "void %sOpenGLShutdown()\n"
+          "{\n"
+          "  GEN_LockInit();\n"
+          "  if (GEN_Initialized && GEN_OpenGLReferences > 1)\n"
+          "  {\n"
+          "    %sUnloadOpenGL();\n"
+          "  }\n"
+          "  else if (GEN_Initialized)\n"
+          "  {\n"
+          "    GEN_AtomicStoreRelease(&GEN_Published, 0);\n"
+          "    for (int Index = 0; Index < GEN_PROC_COUNT; ++Index)\n"
+          "    {\n"
+          "      GEN_Procs[Index] = 0;\n"
+          "    }\n"
+          "%s%s"
+          "    GEN_DriverIdentity = 0;\n"
+          "    GEN_Initialized = 0;\n"
+          "    %sUnloadOpenGL();\n"
+          "  }\n"
+          "  GEN_UnlockInit();\n"
+          "}\n\n";
+        fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix,
+                FeatureCount && !Settings->Lazy ? "GEN_ResolveAvailableProcs();" : "GEN_ResolveProcs(GEN_Procs);",
+                *LoadExtensions ? "    " : "", LoadExtensions, InitResets, Prefix,
+                Prefix, ExtensionCount ? "    memset(GEN_Extensions, 0, sizeof(GEN_Extensions));\n" : "",
+                ClearMasks, Prefix);
+
+        if (Settings->ProgramCache)
+        {
+          WriteProgramCache(Output, Prefix);
+        }
+
+        if (Settings->Shared)
+        {
+          WriteSharedTable(Output, Prefix, Settings->Fallbacks && !Settings->Lazy);
+        }
+
+        if (Settings->Instrument)
+        {
+          WriteInstrumentationReport(Output, Prefix);
+        }
+
+        if (Settings->Capture)
+        {
+          WriteCaptureReplay(Output, Prefix, Functions, UsedFunctionCount);
+        }
+
+        if (Settings->Dispatch)
+        {
+          Generated =
+            "void %sOpenGLInitDispatch(%sOpenGLDispatch* Dispatch)\n"
+            "{\n"
+            "  GEN_LockInit();\n"
+            "  GEN_AcquireOpenGL();\n"
+            "  GEN_UnlockInit();\n"
+            "  GEN_ResolveProcs(Dispatch->Procs);\n"
+            "}\n\n"
+            "void %sOpenGLMakeDispatchCurrent(%sOpenGLDispatch* Dispatch)\n"
+            "{\n"
+            "  GEN_CurrentDispatch = Dispatch ? Dispatch : &GEN_Dispatch;\n"
+            "}\n\n"
+            "%sOpenGLDispatch* %sOpenGLGetCurrentDispatch()\n"
+            "{\n"
+            "  return GEN_CurrentDispatch;\n"
+            "}\n\n";
+          fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix, Prefix, Prefix);
+        }
+
+        if (Settings->Async)
+        {
+          //NOTE: On Windows wglGetProcAddress needs a current context, so the
+          // worker only exists on platforms where lookups are context free.
+          WriteAtomics(Output);
+          const char* LoadReady = FeatureCount ? "GEN_LoadFeatures();\n" : LoadExtensions;
+          if (FeatureCount && !Settings->Lazy)
+          {
+            //NOTE: The worker resolves every function before there is a
+            // context to ask, so OpenGLWaitReady drops the unsupported ones.
+            Generated =
+              "// Clears the functions of features the context doesn't support, after\n"
+              "// the worker resolved all of them.\n"
+              "static void GEN_DropUnavailableProcs()\n"
+              "{\n"
+              "  for (int Feature = 0; Feature < %sOpenGLFeatureCount; ++Feature)\n"
+              "  {\n"
+              "    if (!%sOpenGLHasFeature((%sOpenGLFeature)Feature))\n"
+              "    {\n"
+              "      for (int Index = GEN_FeatureProcs[Feature]; Index < GEN_FeatureProcs[Feature + 1]; ++Index)\n"
+              "      {\n"
+              "        GEN_Procs[Index] = 0;\n"
+              "      }\n"
+              "    }\n"
+              "  }\n"
+              "%s"
+              "}\n\n";
+            fprintf(Output, Generated, Prefix, Prefix, Prefix,
+                    Settings->Fallbacks ? "  GEN_StubMissingProcs(GEN_Procs);\n" : "");
+            LoadReady = "GEN_LoadFeatures();\n  GEN_DropUnavailableProcs();\n";
+          }
+          Generated =
+            "static volatile long GEN_Ready;\n"
+            "#ifdef _WIN32\n"
+            "static void GEN_StartResolveThread()\n"
+            "{\n"
+            "}\n"
+            "static void GEN_JoinResolveThread()\n"
+            "{\n"
+            "  GEN_ResolveProcs(GEN_Procs);\n"
+            "  GEN_AtomicStoreRelease(&GEN_Ready, 1);\n"
+            "}\n"
+            "#else\n"
+            "#include <pthread.h>\n"
+            "static pthread_t GEN_ResolveThread;\n"
+            "static int GEN_ResolveThreadStarted;\n"
+            "static void* GEN_ResolveThreadProc(void* Param)\n"
+            "{\n"
+            "  (void)Param;\n"
+            "  GEN_ResolveProcs(GEN_Procs);\n"
+            "  GEN_AtomicStoreRelease(&GEN_Ready, 1);\n"
+            "  return 0;\n"
+            "}\n"
+            "static void GEN_StartResolveThread()\n"
+            "{\n"
+            "  GEN_ResolveThreadStarted = pthread_create(&GEN_ResolveThread, 0, GEN_ResolveThreadProc, 0) == 0;\n"
+            "  if (!GEN_ResolveThreadStarted)\n"
+            "  {\n"
+            "    GEN_ResolveThreadProc(0);\n"
+            "  }\n"
+            "}\n"
+            "static void GEN_JoinResolveThread()\n"
+            "{\n"
+            "  while (!GEN_AtomicLoadAcquire(&GEN_Ready))\n"
+            "  {\n"
+            "    GEN_Yield();\n"
+            "  }\n"
+            "  if (GEN_ResolveThreadStarted)\n"
+            "  {\n"
+            "    pthread_join(GEN_ResolveThread, 0);\n"
+            "    GEN_ResolveThreadStarted = 0;\n"
+            "  }\n"
+            "}\n"
+            "#endif\n\n"
+            "// Loads OpenGL and starts resolving function pointers on a worker thread.\n"
+            "// Call it as early as possible, the context doesn't need to exist yet.\n"
+            "void %sOpenGLInitAsync()\n"
+            "{\n"
+            "  GEN_AtomicStoreRelease(&GEN_Ready, 0);\n"
+            "  GEN_LockInit();\n"
+            "  GEN_AcquireOpenGL();\n"
+            "  GEN_UnlockInit();\n"
+            "  GEN_StartResolveThread();\n"
+            "}\n\n"
+            "// Returns non zero once all function pointers have been published.\n"
+            "int %sOpenGLIsReady()\n"
+            "{\n"
+            "  return GEN_AtomicLoadAcquire(&GEN_Ready) != 0;\n"
+            "}\n\n"
+            "// Blocks until all function pointers are published. Must be called\n"
+            "// before any OpenGL function, with the context current.\n"
+            "void %sOpenGLWaitReady(%sOpenGLVersion* Version)\n"
+            "{\n"
+            "  GEN_LockInit();\n"
+            "  GEN_JoinResolveThread();\n"
+            "  GEN_DriverIdentity = GEN_GetDriverIdentity();\n"
+            "%s%s"
+            "%s"
+            "  GEN_AtomicStoreRelease(&GEN_Published, 1);\n"
+            "  GEN_UnlockInit();\n"
+            "\n"
+            "  Version->Major = 0;\n"
+            "  Version->Minor = 0;\n"
+            "  if (GEN_glGetIntegerv)\n"
+            "  {\n"
+            "    glGetIntegerv(GL_MAJOR_VERSION, &Version->Major);\n"
+            "    glGetIntegerv(GL_MINOR_VERSION, &Version->Minor);\n"
+            "  }\n"
+            "}\n\n";
+          fprintf(Output, Generated, Prefix, Prefix, Prefix, Prefix,
+                  *LoadReady ? "  " : "", LoadReady, InitResets);
+        }
+      }
+      if (Locations && (Locations->UniformCount || Locations->AttributeCount))
+      {
+        WriteLocations(Output, Prefix, Locations);
+      }
+      fprintf(Output, "#endif // INCLUDE_OPENGL_GENERATED_H\n");
+      if (Locations)
+      {
+        for (unsigned int Index = 0; Index < Locations->UniformCount; ++Index)
+        {
+          free(Locations->Uniforms[Index].Chars);
+        }
+        for (unsigned int Index = 0; Index < Locations->AttributeCount; ++Index)
+        {
+          free(Locations->Attributes[Index].Chars);
+        }
+        free(Locations);
       }
+      free(Extensions);
+      free(Functions);
       Success = 0;
       if (!Settings->Silent)
       {
@@ -1146,6 +6810,21 @@ int GenerateOpenGLHeader(GLSettings* Settings)
     fclose(Output);
   }
 
+  if (Stats && Success == 0)
+  {
+    EndPhase(Stats, PhaseEmit);
+  }
+  if (Stats && Stats->Trace)
+  {
+    WriteTraceEvent(Stats, "GenerateOpenGLHeader", Start, GetWallClock(), 0, 0);
+    fprintf(Stats->Trace, "\n]}\n");
+    fclose(Stats->Trace);
+  }
+  if (Settings->StatsFile && Success == 0)
+  {
+    ReportStats(Stats, Settings);
+  }
+
   if (ArbData)
   {
     free(ArbData);